@@ -0,0 +1,76 @@
+#!/bin/bash
+#
+# BENCH.SH - Przegląd parametrów systemu (make bench)
+#
+# Uruchamia prawdziwy system (wszystkie procesy i IPC) dla każdej kombinacji
+# N, P, R, T, częstości przybyć i zasady odjazdu, ze stałym ziarnem i przyspieszonym czasem,
+# po BENCH_SECS sekundach wysyła SIGINT, a metryki z report.bin (benchstat)
+# dopisuje jako wiersz CSV. Działa bez terminala (CI).
+#
+# Siatkę i parametry można nadpisać zmiennymi środowiska, np.:
+#   BENCH_N="1 2 4" BENCH_SECS=5 make bench
+#   BENCH_POLICY="fixed full minload headway" make bench   # porównanie zasad odjazdu
+#   BENCH_PERF=1 make bench   # liczniki sprzętowe perf (odwołania do cache / chybienia, wszystkie procesy)
+#
+
+BENCH_N=${BENCH_N:-"2 4"}                 # Liczba autobusów
+BENCH_P=${BENCH_P:-"10 40"}               # Pojemność autobusu
+BENCH_R=${BENCH_R:-"2"}                   # Miejsca na rowery
+BENCH_T=${BENCH_T:-"2 4"}                 # Postój (sekundy modelu)
+BENCH_RATE=${BENCH_RATE:-"1 4"}           # Mnożnik częstości przybyć
+BENCH_PLATFORMS=${BENCH_PLATFORMS:-1}     # Stanowiska na dworcu
+BENCH_POLICY=${BENCH_POLICY:-full}        # Zasady odjazdu (--policy)
+BENCH_SCALE=${BENCH_SCALE:-50}            # Przyspieszenie czasu
+BENCH_SECS=${BENCH_SECS:-3}               # Czas jednego przebiegu (sekundy rzeczywiste)
+BENCH_SEED=${BENCH_SEED:-1}               # Ziarno losowań
+BENCH_OUT=${BENCH_OUT:-bench.csv}         # Plik wynikowy
+BENCH_PERF=${BENCH_PERF:-0}               # 1 = perf stat -e cache-references,cache-misses
+
+PERF_OUT=perf.csv                          # Wynik perf stat jednego przebiegu (format -x,)
+if [ "$BENCH_PERF" = 1 ] && ! command -v perf > /dev/null; then
+    echo "BENCH_PERF=1: brak programu perf - kolumny cache puste" >&2
+    BENCH_PERF=0
+fi
+
+cd "$(dirname "$0")" || exit 1
+
+echo "N,P,R,T,arrival_rate,policy,platforms,time_scale,seed,$(./benchstat --header),cache_refs,cache_misses" > "$BENCH_OUT"
+
+runs=0
+for n in $BENCH_N; do
+for p in $BENCH_P; do
+for r in $BENCH_R; do
+for t in $BENCH_T; do
+for rate in $BENCH_RATE; do
+for policy in $BENCH_POLICY; do
+    args=("$n" "$p" "$r" "$t" --binary-log --seed "$BENCH_SEED" --time-scale "$BENCH_SCALE"
+          --arrival-rate "$rate" --policy "$policy" --platforms "$BENCH_PLATFORMS")
+    refs="" misses=""
+    if [ "$BENCH_PERF" = 1 ]; then
+        # perf liczy main i wszystkie procesy potomne; SIGINT dostaje main, nie perf
+        perf stat -x, -e cache-references,cache-misses -o "$PERF_OUT" ./main "${args[@]}" > /dev/null &
+        pid=$!
+        sleep "$BENCH_SECS"
+        pkill -INT -P "$pid" -x main
+        wait "$pid"
+        refs=$(awk -F, '$3 == "cache-references" { print $1 }' "$PERF_OUT")
+        misses=$(awk -F, '$3 == "cache-misses" { print $1 }' "$PERF_OUT")
+    else
+        ./main "${args[@]}" > /dev/null &
+        pid=$!
+        sleep "$BENCH_SECS"
+        kill -INT "$pid"
+        wait "$pid"
+    fi
+    row=$(./benchstat report.bin) || exit 1
+    echo "$n,$p,$r,$t,$rate,$policy,$BENCH_PLATFORMS,$BENCH_SCALE,$BENCH_SEED,$row,$refs,$misses" >> "$BENCH_OUT"
+    runs=$((runs + 1))
+    echo "[$runs] N=$n P=$p R=$r T=$t rate=$rate policy=$policy"
+done
+done
+done
+done
+done
+done
+
+echo "Wyniki: $BENCH_OUT ($runs przebiegow)"
@@ -0,0 +1,195 @@
+/*
+ * BENCHSTAT.C - Metryki przebiegu z raportu binarnego (make bench)
+ *
+ * Narzędzie czyta report.bin (opcja --binary-log) i wypisuje jeden wiersz
+ * CSV z metrykami przebiegu:
+ * - czas trwania (start → shutdown), liczba przybyć, przewiezionych i odjazdów
+ * - przewiezieni pasażerowie na sekundę i średnie wypełnienie autobusu
+ * - percentyle czasu rejestracja→bilet (EV_PASSENGER_TICKET)
+ * - średnia i percentyle czasu przybycie→wejście do autobusu (pary po PID pasażera)
+ * - czas CPU i przełączenia kontekstu komponentów (EV_MAIN_RUSAGE)
+ *
+ * Użycie:
+ *   ./benchstat --header         - wypisuje tylko nagłówek CSV
+ *   ./benchstat [report.bin]     - wypisuje wiersz metryk
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "evlog.h"
+
+/*
+ * Struktura Stamp - zdarzenie pasażera (do łączenia przybycia z wejściem)
+ */
+struct Stamp {
+    int32_t pid;
+    uint64_t ts;
+};
+
+int cmp_stamp(const void* a, const void* b) {
+    const struct Stamp* x = a;
+    const struct Stamp* y = b;
+    if (x->pid != y->pid) return x->pid < y->pid ? -1 : 1;
+    return x->ts < y->ts ? -1 : x->ts > y->ts;
+}
+
+int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Funkcja pct - percentyl q (0..100) posortowanej tablicy, 0 gdy pusta
+ */
+uint64_t pct(const uint64_t* v, size_t n, int q) {
+    if (n == 0) return 0;
+    size_t i = (n - 1) * (size_t)q / 100;
+    return v[i];
+}
+
+void print_header() {
+    printf("duration_s,arrivals,boarded,departures,boarded_per_s,load_factor,"
+           "ticket_p50_us,ticket_p99_us,board_mean_ms,board_p50_ms,board_p90_ms,board_p99_ms");
+    for (int c = 0; c < EV_COMP_COUNT; c++) {
+        printf(",cpu_ms_%s,csw_%s", ev_comp_names[c], ev_comp_names[c]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--header") == 0) {
+        print_header();
+        return 0;
+    }
+    const char* in_path = argc > 1 ? argv[1] : EV_REPORT_BIN;
+
+    // === MAPOWANIE PLIKU BINARNEGO (jak w busdump) ===
+    int fd = open(in_path, O_RDONLY);
+    if (fd == -1) {
+        perror("open");
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct EvFileHeader)) {
+        fprintf(stderr, "%s: plik za krotki\n", in_path);
+        close(fd);
+        return 1;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    const struct EvFileHeader* hdr = map;
+    if (memcmp(hdr->magic, EV_MAGIC, sizeof(EV_MAGIC)) != 0 ||
+        hdr->version != EV_VERSION ||
+        hdr->record_size != sizeof(struct EvRecord)) {
+        fprintf(stderr, "%s: nieznany format pliku\n", in_path);
+        munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+    const struct EvRecord* recs = (const struct EvRecord*)((const char*)map + sizeof(*hdr));
+    size_t count = ((size_t)st.st_size - sizeof(*hdr)) / sizeof(struct EvRecord);
+
+    // === ZBIERANIE ZDARZEŃ ===
+    // Rekordy z pierścienia logów nie muszą być uporządkowane po czasie -
+    // przybycia i wejścia łączymy po PID pasażera, nie po kolejności
+    struct Stamp* arr = malloc((count + 1) * sizeof(*arr));
+    struct Stamp* brd = malloc((count + 1) * sizeof(*brd));
+    uint64_t* ticket = malloc((count + 1) * sizeof(*ticket));
+    uint64_t* board = malloc((count + 1) * sizeof(*board));
+    if (!arr || !brd || !ticket || !board) {
+        perror("malloc");
+        return 1;
+    }
+    size_t na = 0, nb = 0, nt = 0, nl = 0;
+    uint64_t t_start = 0, t_end = 0, t_last = 0;
+    int P = 0;
+    long boarded = 0, departures = 0;
+    double load_sum = 0;
+    long cpu_ms[EV_COMP_COUNT] = { 0 }, csw[EV_COMP_COUNT] = { 0 };
+
+    for (size_t i = 0; i < count; i++) {
+        const struct EvRecord* e = &recs[i];
+        if (e->ts_ns > t_last) t_last = e->ts_ns;
+        switch (e->type) {
+        case EV_MAIN_START:
+            t_start = e->ts_ns;
+            P = e->passengers;
+            break;
+        case EV_MAIN_SHUTDOWN:
+            if (t_end == 0) t_end = e->ts_ns;
+            break;
+        case EV_PASSENGER_ARRIVE:
+            arr[na++] = (struct Stamp){ e->pid, e->ts_ns };
+            break;
+        case EV_PASSENGER_BOARD:
+        case EV_FAMILY_BOARD:
+            brd[nb++] = (struct Stamp){ e->pid, e->ts_ns };
+            break;
+        case EV_PASSENGER_TICKET:
+            ticket[nt++] = (uint64_t)e->arg;
+            break;
+        case EV_DRIVER_DEPART:
+            boarded += e->passengers;
+            departures++;
+            if (P > 0) load_sum += (double)e->passengers / P;
+            break;
+        case EV_MAIN_RUSAGE:
+            if (e->passengers >= 0 && e->passengers < EV_COMP_COUNT) {
+                cpu_ms[e->passengers] += e->arg;
+                csw[e->passengers] += e->arg2;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if (t_end == 0) t_end = t_last;  // Przebieg bez shutdown (np. przerwany)
+
+    // === ŁĄCZENIE PRZYBYCIE → WEJŚCIE ===
+    qsort(arr, na, sizeof(*arr), cmp_stamp);
+    qsort(brd, nb, sizeof(*brd), cmp_stamp);
+    size_t j = 0;
+    double board_sum = 0;  // Do średniego czasu oczekiwania
+    for (size_t i = 0; i < nb; i++) {
+        while (j < na && (arr[j].pid < brd[i].pid)) j++;
+        // Ostatnie przybycie tego PID przed wejściem (PID mógł zostać użyty ponownie)
+        size_t k = j;
+        while (k + 1 < na && arr[k + 1].pid == brd[i].pid && arr[k + 1].ts <= brd[i].ts) k++;
+        if (k < na && arr[k].pid == brd[i].pid && arr[k].ts <= brd[i].ts) {
+            board[nl++] = brd[i].ts - arr[k].ts;
+            board_sum += brd[i].ts - arr[k].ts;
+        }
+    }
+    qsort(ticket, nt, sizeof(*ticket), cmp_u64);
+    qsort(board, nl, sizeof(*board), cmp_u64);
+
+    // === WIERSZ CSV ===
+    double dur = t_end > t_start ? (double)(t_end - t_start) / 1e9 : 0;
+    printf("%.3f,%zu,%ld,%ld,%.2f,%.3f,%llu,%llu,%.2f,%.2f,%.2f,%.2f",
+           dur, na, boarded, departures,
+           dur > 0 ? boarded / dur : 0,
+           departures > 0 ? load_sum / departures : 0,
+           (unsigned long long)pct(ticket, nt, 50), (unsigned long long)pct(ticket, nt, 99),
+           nl > 0 ? board_sum / nl / 1e6 : 0,
+           pct(board, nl, 50) / 1e6, pct(board, nl, 90) / 1e6, pct(board, nl, 99) / 1e6);
+    for (int c = 0; c < EV_COMP_COUNT; c++) {
+        printf(",%ld,%ld", cpu_ms[c], csw[c]);
+    }
+    printf("\n");
+
+    free(arr);
+    free(brd);
+    free(ticket);
+    free(board);
+    munmap(map, (size_t)st.st_size);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * BOARD.H - Wsiadanie do autobusu: wybór stanowiska i CAS na słowie wsiadania
+ *
+ * Szybka ścieżka pasażera (passenger.c try_board) wydzielona do nagłówka,
+ * żeby test obciążeniowy (boardstress.c, make stress) i symulacja (sim.c)
+ * wsiadały dokładnie tym samym kodem co prawdziwi pasażerowie. Funkcje
+ * działają na słowach wsiadania i pojemności (P, R), a nie na BusState -
+ * sim.c trzyma stanowiska we własnej tablicy.
+ *
+ * Słowo wsiadania (BOARD_*, ipc.h) zmieniane jest wyłącznie atomowo:
+ * - pasażer: CAS w -> w + BOARD_MAKE(miejsca, rowery), gdy board_fits(w, P, R, ...)
+ * - kierowca: __atomic_fetch_or(BOARD_DEPARTING) przy zamykaniu drzwi,
+ *   __atomic_exchange_n(BOARD_DEPARTING) przy zwolnieniu stanowiska,
+ *   __atomic_store_n(BOARD_MAKE(0, 0)) przy otwarciu drzwi
+ * Niezmiennik: słowo nigdy nie przekracza P pasażerów ani R rowerów.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "ipc.h"
+
+/*
+ * Funkcja board_fits - czy pasażer mieści się w autobusie o stanie w
+ * Parametry:
+ *   w - słowo wsiadania stanowiska
+ *   P, R - pojemność autobusu (pasażerowie, rowery)
+ *   seats, bikes - potrzebne miejsca i miejsca na rowery
+ */
+static inline int board_fits(unsigned long long w, int P, int R, int seats, int bikes) {
+    return !(w & BOARD_DEPARTING) &&
+           BOARD_PASSENGERS(w) + seats <= P &&
+           BOARD_BIKES(w) + bikes <= R;
+}
+
+/*
+ * Funkcja board_pick - wybór stanowiska z największym wolnym miejscem
+ * Parametry:
+ *   st, platforms - stanowiska (bus->platform albo tablica symulacji)
+ *   P, R - pojemność autobusu
+ *   seats, bikes - potrzebne miejsca i miejsca na rowery
+ *   w - [wyjście] odczytane słowo wsiadania wybranego stanowiska
+ *
+ * Pasażer z rowerem patrzy na wolne miejsca na rowery (a przy remisie na
+ * siedzenia), pozostali tylko na wolne siedzenia.
+ * Zwraca numer stanowiska albo -1 gdy nigdzie się nie mieścimy.
+ */
+static inline int board_pick(const struct Platform* st, int platforms, int P, int R,
+                             int seats, int bikes, unsigned long long* w) {
+    int best = -1;
+    int best_bikes = -1, best_seats = -1;
+    for (int i = 0; i < platforms; i++) {
+        unsigned long long cur = __atomic_load_n(&st[i].board, __ATOMIC_ACQUIRE);
+        if (!board_fits(cur, P, R, seats, bikes)) continue;
+        int free_seats = P - BOARD_PASSENGERS(cur);
+        int free_bikes = bikes ? R - BOARD_BIKES(cur) : 0;
+        if (free_bikes > best_bikes || (free_bikes == best_bikes && free_seats > best_seats)) {
+            best = i;
+            best_bikes = free_bikes;
+            best_seats = free_seats;
+            *w = cur;
+        }
+    }
+    return best;
+}
+
+/*
+ * Funkcja board_enter - wejście do autobusu jednym CAS
+ * Parametry:
+ *   board - słowo wsiadania stanowiska wybranego przez board_pick
+ *   w - słowo odczytane przez board_pick
+ *   add - BOARD_MAKE(miejsca, rowery)
+ *
+ * CAS naraz sprawdza limit P, limit R i flagę odjazdu: udaje się tylko
+ * wtedy, gdy słowo od odczytu się nie zmieniło, a board_fits(w) było
+ * prawdą. Zwraca 1 = weszliśmy (słowo to w + add), 0 = ktoś nas wyprzedził
+ * (wybierz stanowisko od nowa).
+ */
+static inline int board_enter(unsigned long long* board, unsigned long long w, unsigned long long add) {
+    return __atomic_compare_exchange_n(board, &w, w + add, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#endif
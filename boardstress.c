@@ -0,0 +1,232 @@
+/*
+ * BOARDSTRESS.C - Test obciążeniowy wsiadania przez CAS (make stress)
+ *
+ * Uruchomienie: ./boardstress [SEKUNDY] [PASAZEROWIE] [STANOWISKA] [P] [R]
+ * (domyślnie 3 s, 32 procesy pasażerów, MAX_PLATFORMS stanowisk, P=10, R=3)
+ *
+ * Bez reszty systemu (kasy, loggera, IPC SysV): BusState leży w anonimowej
+ * pamięci dzielonej, a procesy wywołują tę samą szybką ścieżkę co
+ * passenger.c try_board() - board_pick() i board_enter() z board.h.
+ * - pasażerowie (PASAZEROWIE procesów) w pętli losują 1-2 miejsca i rower
+ *   i próbują wejść na dowolne otwarte stanowisko,
+ * - kierowca każdego stanowiska w pętli otwiera drzwi (BOARD_MAKE(0, 0)),
+ *   czeka losowo krótko, zamyka je (__atomic_fetch_or BOARD_DEPARTING)
+ *   i zwalnia stanowisko (__atomic_exchange_n) - jak driver.c.
+ *
+ * Sprawdzane niezmienniki:
+ * - słowo po udanym CAS pasażera i przy odjeździe: najwyżej P pasażerów
+ *   i R rowerów,
+ * - po zamknięciu drzwi nikt już nie wsiada (słowo przy zwolnieniu
+ *   stanowiska równe słowu z chwili zamknięcia),
+ * - suma miejsc i rowerów z udanych CAS = suma z odjazdów (żadne wejście
+ *   nie zginęło ani nie zostało policzone dwa razy).
+ * Kod wyjścia 0 = wszystko się zgadza, 1 = naruszenie, 2 = błąd uruchomienia.
+ */
+
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "ipc.h"
+#include "board.h"
+#include "rng.h"
+
+#define STRESS_SEED 1           // Stałe ziarno - powtarzalne losowania procesów
+#define STRESS_OPEN_MAX 64      // Najdłuższy postój: tyle sched_yield() przy otwartych drzwiach
+#define STRESS_YIELD_EVERY 4    // Średnio co tyle prób - sched_yield() między board_pick a board_enter
+
+/*
+ * Struktura StressShared - stan testu w anonimowej pamięci dzielonej
+ */
+struct StressShared {
+    struct BusState bus;        // Słowa wsiadania stanowisk, P, R, platforms
+    int stop;                   // 1 = koniec testu (ustawia proces główny)
+    long boarded_seats;         // Miejsca zajęte udanymi CAS (suma od pasażerów)
+    long boarded_bikes;         // Rowery z udanych CAS
+    long departed_seats;        // Miejsca policzone przy odjazdach (suma od kierowców)
+    long departed_bikes;        // Rowery policzone przy odjazdach
+    long departures;            // Liczba odjazdów
+    long cas_ok, cas_fail;      // Udane i nieudane CAS pasażerów
+    long violations;            // Naruszenia niezmienników
+};
+
+struct StressShared* sh;
+
+/*
+ * Funkcja violation - zgłasza naruszenie niezmiennika
+ */
+void violation(const char* who, int pl, unsigned long long w) {
+    __atomic_fetch_add(&sh->violations, 1, __ATOMIC_RELAXED);
+    fprintf(stderr, "boardstress: %s, stanowisko %d: %d/%d pasazerow, %d/%d rowerow%s\n",
+            who, pl, BOARD_PASSENGERS(w), sh->bus.P, BOARD_BIKES(w), sh->bus.R,
+            (w & BOARD_DEPARTING) ? ", drzwi zamkniete" : "");
+}
+
+/*
+ * Funkcja passenger_loop - proces pasażera: wsiadanie w pętli do końca testu
+ * Parametry:
+ *   index - numer procesu (strumień losowy)
+ */
+void passenger_loop(int index) {
+    struct BusState* b = &sh->bus;
+    struct Rng rng;
+    rng_init(&rng, STRESS_SEED, RNG_PASSENGER, (uint32_t)index);
+    long seats = 0, bikes = 0, ok = 0, fail = 0;
+
+    while (!__atomic_load_n(&sh->stop, __ATOMIC_ACQUIRE)) {
+        int need_seats = rng_below(&rng, 5) == 0 ? 2 : 1;  // Co piąty z dzieckiem
+        int need_bikes = rng_below(&rng, 2);
+        unsigned long long add = BOARD_MAKE(need_seats, need_bikes);
+        unsigned long long w = 0;
+        int pl = board_pick(b->platform, b->platforms, b->P, b->R, need_seats, need_bikes, &w);
+        if (pl == -1) {
+            sched_yield();  // Nigdzie miejsca - oddaj procesor kierowcom
+            continue;
+        }
+        // Co któreś podejście oddaje procesor między odczytem słowa a CAS -
+        // inni zdążą je zmienić, więc przeplot zachodzi także na jednym rdzeniu
+        if (rng_below(&rng, STRESS_YIELD_EVERY) == 0) sched_yield();
+        if (!board_enter(&b->platform[pl].board, w, add)) {
+            fail++;
+            continue;
+        }
+        unsigned long long after = w + add;
+        if (BOARD_PASSENGERS(after) > b->P || BOARD_BIKES(after) > b->R || (after & BOARD_DEPARTING)) {
+            violation("pasazer", pl, after);
+        }
+        seats += need_seats;
+        bikes += need_bikes;
+        ok++;
+    }
+
+    __atomic_fetch_add(&sh->boarded_seats, seats, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sh->boarded_bikes, bikes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sh->cas_ok, ok, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sh->cas_fail, fail, __ATOMIC_RELAXED);
+}
+
+/*
+ * Funkcja driver_loop - proces kierowcy: cykle otwarcie / odjazd na stanowisku
+ * Parametry:
+ *   pl - stanowisko
+ */
+void driver_loop(int pl) {
+    struct BusState* b = &sh->bus;
+    struct Platform* st = &b->platform[pl];
+    struct Rng rng;
+    rng_init(&rng, STRESS_SEED, RNG_DRIVER, (uint32_t)pl);
+    long seats = 0, bikes = 0, departures = 0;
+
+    while (!__atomic_load_n(&sh->stop, __ATOMIC_ACQUIRE)) {
+        // Otwarcie drzwi - pusty autobus
+        __atomic_store_n(&st->board, BOARD_MAKE(0, 0), __ATOMIC_RELEASE);
+
+        // Postój: losowo krótki, żeby odjazdy trafiały też w trakcie CAS pasażerów
+        int open = rng_below(&rng, STRESS_OPEN_MAX);
+        for (int i = 0; i < open; i++) sched_yield();
+
+        // Zamknięcie drzwi - słowo z tej chwili to stan autobusu przy odjeździe
+        unsigned long long w = __atomic_fetch_or(&st->board, BOARD_DEPARTING, __ATOMIC_ACQ_REL);
+        if (BOARD_PASSENGERS(w) > b->P || BOARD_BIKES(w) > b->R) {
+            violation("odjazd", pl, w);
+        }
+
+        // Zwolnienie stanowiska - po zamknięciu drzwi słowo nie może się zmienić
+        unsigned long long left = __atomic_exchange_n(&st->board, BOARD_DEPARTING, __ATOMIC_ACQ_REL);
+        if (left != (w | BOARD_DEPARTING)) {
+            violation("wejscie po zamknieciu drzwi", pl, left);
+        }
+
+        seats += BOARD_PASSENGERS(w);
+        bikes += BOARD_BIKES(w);
+        departures++;
+    }
+
+    __atomic_fetch_add(&sh->departed_seats, seats, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sh->departed_bikes, bikes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sh->departures, departures, __ATOMIC_RELAXED);
+}
+
+/*
+ * Funkcja spawn - uruchamia proces potomny wykonujący fn(arg)
+ * Zwraca PID albo -1 przy błędzie fork()
+ */
+pid_t spawn(void (*fn)(int), int arg) {
+    pid_t p = fork();
+    if (p == 0) {
+        fn(arg);
+        _exit(0);
+    }
+    return p;
+}
+
+int main(int argc, char** argv) {
+    int secs = argc > 1 ? atoi(argv[1]) : 3;
+    int passengers = argc > 2 ? atoi(argv[2]) : 32;
+    int platforms = argc > 3 ? atoi(argv[3]) : MAX_PLATFORMS;
+    int P = argc > 4 ? atoi(argv[4]) : 10;
+    int R = argc > 5 ? atoi(argv[5]) : 3;
+    if (secs < 1 || passengers < 1 || platforms < 1 || platforms > MAX_PLATFORMS || P < 1 || R < 0) {
+        fprintf(stderr, "Uzycie: %s [SEKUNDY] [PASAZEROWIE] [STANOWISKA 1..%d] [P] [R]\n", argv[0], MAX_PLATFORMS);
+        return 2;
+    }
+
+    // === PAMIĘĆ DZIELONA TESTU ===
+    // Anonimowa i dzielona - dziedziczą ją procesy potomne, znika z ostatnim z nich
+    sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED) {
+        perror("mmap");
+        return 2;
+    }
+    sh->bus.P = P;
+    sh->bus.R = R;
+    sh->bus.platforms = platforms;
+    for (int i = 0; i < MAX_PLATFORMS; i++) {
+        sh->bus.platform[i].board = BOARD_DEPARTING;  // Brak autobusu - drzwi zamknięte
+    }
+
+    // === PROCESY ===
+    pid_t* pids = calloc(platforms + passengers, sizeof(pid_t));
+    if (!pids) {
+        perror("calloc");
+        return 2;
+    }
+    int n = 0;
+    for (int i = 0; i < platforms; i++) pids[n++] = spawn(driver_loop, i);
+    for (int i = 0; i < passengers; i++) pids[n++] = spawn(passenger_loop, i);
+    for (int i = 0; i < n; i++) {
+        if (pids[i] == -1) {
+            perror("fork");
+            __atomic_store_n(&sh->stop, 1, __ATOMIC_RELEASE);
+            while (wait(NULL) > 0);
+            return 2;
+        }
+    }
+
+    sleep(secs);
+    __atomic_store_n(&sh->stop, 1, __ATOMIC_RELEASE);
+
+    int failed_children = 0;
+    int status;
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed_children++;
+    }
+
+    // === WYNIK ===
+    int lost = sh->boarded_seats != sh->departed_seats || sh->boarded_bikes != sh->departed_bikes;
+    printf("boardstress: %d s, %d pasazerow, %d stanowisk, P=%d R=%d\n", secs, passengers, platforms, P, R);
+    printf("  odjazdy %ld, wejscia %ld (CAS nieudane %ld)\n", sh->departures, sh->cas_ok, sh->cas_fail);
+    printf("  miejsca: wsiadlo %ld, odjechalo %ld; rowery: wsiadlo %ld, odjechalo %ld\n",
+           sh->boarded_seats, sh->departed_seats, sh->boarded_bikes, sh->departed_bikes);
+    printf("  naruszenia %ld%s%s\n", sh->violations,
+           lost ? ", niezgodna suma wejsc i odjazdow" : "",
+           failed_children ? ", nieudane procesy potomne" : "");
+
+    int ok = sh->violations == 0 && !lost && failed_children == 0 && sh->departures > 0;
+    printf("%s\n", ok ? "OK" : "BLAD");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/*
+ * BUSDUMP.C - Konwerter Raportu Binarnego
+ *
+ * Narzędzie zamienia plik report.bin (opcja --binary-log) na tekstowy
+ * raport w dotychczasowym formacie report.txt, dzięki czemu istniejące
+ * skrypty i narzędzia czytające raport działają bez zmian.
+ *
+ * Użycie:
+ *   ./busdump [report.bin] [plik_wyjściowy]
+ * Domyślnie czyta report.bin i pisze na standardowe wyjście.
+ *
+ * Plik jest mapowany do pamięci (mmap) - rekordy czytamy bezpośrednio
+ * z mapowania, bez kopiowania i parsowania.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "evlog.h"
+
+int main(int argc, char** argv) {
+    const char* in_path = argc > 1 ? argv[1] : EV_REPORT_BIN;
+    const char* out_path = argc > 2 ? argv[2] : NULL;
+
+    // === MAPOWANIE PLIKU BINARNEGO ===
+    int fd = open(in_path, O_RDONLY);
+    if (fd == -1) {
+        perror("open");
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("fstat");
+        close(fd);
+        return 1;
+    }
+    if ((size_t)st.st_size < sizeof(struct EvFileHeader)) {
+        fprintf(stderr, "%s: plik za krotki\n", in_path);
+        close(fd);
+        return 1;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // Mapowanie pozostaje ważne po zamknięciu deskryptora
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    // === WERYFIKACJA NAGŁÓWKA ===
+    const struct EvFileHeader* hdr = map;
+    if (memcmp(hdr->magic, EV_MAGIC, sizeof(EV_MAGIC)) != 0 ||
+        hdr->version != EV_VERSION ||
+        hdr->record_size != sizeof(struct EvRecord)) {
+        fprintf(stderr, "%s: nieznany format pliku\n", in_path);
+        munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+
+    const struct EvRecord* recs = (const struct EvRecord*)((const char*)map + sizeof(*hdr));
+    size_t count = ((size_t)st.st_size - sizeof(*hdr)) / sizeof(struct EvRecord);
+
+    // === OTWARCIE WYJŚCIA ===
+    FILE* out = stdout;
+    if (out_path) {
+        out = fopen(out_path, "w");
+        if (!out) {
+            perror("fopen");
+            munmap(map, (size_t)st.st_size);
+            return 1;
+        }
+    }
+
+    // === KONWERSJA REKORDÓW ===
+    // Znacznik HH:MM:SS przeliczamy tylko gdy zmieni się sekunda
+    long long last_sec = -1;
+    char clk[16] = "00:00:00";
+    char ln[256];
+    for (size_t i = 0; i < count; i++) {
+        const struct EvRecord* e = &recs[i];
+        long long sec = ((long long)e->ts_ns + hdr->clock_offset_ns) / 1000000000LL;
+        if (sec != last_sec) {
+            ev_clock(e->ts_ns, hdr->clock_offset_ns, clk, sizeof(clk));
+            last_sec = sec;
+        }
+        int len = ev_format(e, clk, ln, sizeof(ln));
+        if (len > 0) {
+            fwrite(ln, 1, (size_t)len, out);
+        }
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    munmap(map, (size_t)st.st_size);
+    return 0;
+}
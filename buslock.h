@@ -0,0 +1,80 @@
+/*
+ * BUSLOCK.H - Mutex chroniący BusState (wybierany przy kompilacji)
+ *
+ * make            -> semafor SysV nr 0 z SEM_UNDO; każde sem_lock()/sem_unlock()
+ *                    to wywołanie systemowe semop(), także bez rywalizacji
+ * make LOCK=futex -> pthread_mutex_t w segmencie BusState (PTHREAD_PROCESS_SHARED
+ *                    + PTHREAD_MUTEX_ROBUST). W glibc zbudowany na futexie:
+ *                    bez rywalizacji to jedna operacja atomowa w przestrzeni
+ *                    użytkownika, do jądra wchodzimy tylko gdy trzeba czekać.
+ *
+ * Odpowiednik SEM_UNDO w trybie futex: gdy właściciel zginie trzymając mutex,
+ * następny proces dostaje EOWNERDEAD, oznacza mutex jako spójny i pracuje dalej
+ * (sekcje krytyczne to pojedyncze przypisania - stan pozostaje sensowny).
+ *
+ * Zmiana LOCK przebudowuje wszystkie programy (Makefile: plik .buildflags).
+ */
+
+#ifndef BUSLOCK_H
+#define BUSLOCK_H
+
+#include <errno.h>
+#include <sys/ipc.h>
+#include <sys/sem.h>
+#include <pthread.h>
+#include "ipc.h"
+
+#ifdef BUS_LOCK_FUTEX
+
+/*
+ * Funkcja bus_lock_init - przygotowuje mutex w BusState (wywoływana tylko przez main)
+ * Zwraca 0 lub -1 przy błędzie
+ */
+static inline int bus_lock_init(struct BusState* bus) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);  // Wspólny dla procesów
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);  // Przeżywa śmierć właściciela
+    int r = pthread_mutex_init(&bus->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return r == 0 ? 0 : -1;
+}
+
+static inline void bus_lock(struct BusState* bus, int semid) {
+    (void)semid;
+    if (pthread_mutex_lock(&bus->lock) == EOWNERDEAD) {
+        // Poprzedni właściciel zginął w sekcji krytycznej - przejmujemy mutex
+        pthread_mutex_consistent(&bus->lock);
+    }
+}
+
+static inline void bus_unlock(struct BusState* bus, int semid) {
+    (void)semid;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+#else
+
+/*
+ * Tryb semaforów: semafor nr 0 ustawia main przez semctl(SETVAL)
+ */
+static inline int bus_lock_init(struct BusState* bus) {
+    (void)bus;
+    return 0;
+}
+
+static inline void bus_lock(struct BusState* bus, int semid) {
+    (void)bus;
+    struct sembuf sb = { 0, -1, SEM_UNDO };  // Operacja P (wait) na semaforze 0
+    semop(semid, &sb, 1);
+}
+
+static inline void bus_unlock(struct BusState* bus, int semid) {
+    (void)bus;
+    struct sembuf sb = { 0, 1, SEM_UNDO };  // Operacja V (signal) na semaforze 0
+    semop(semid, &sb, 1);
+}
+
+#endif
+
+#endif
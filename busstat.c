@@ -0,0 +1,92 @@
+/*
+ * BUSSTAT.C - Podgląd pracy systemu na żywo (w stylu vmstat)
+ *
+ * Narzędzie podłącza segment statystyk (stats.h) w trybie tylko do odczytu
+ * i co 'interwał' sekund wypisuje wiersz: przyrosty liczników na sekundę
+ * (przybycia, rejestracje, bilety, wejścia, odjazdy, odrzucone dzieci,
+ * odmowy przy zamkniętym dworcu) oraz bieżący stan (poczekalnia, osoby
+ * w autobusach na stanowiskach, wypełnienie w %).
+ *
+ * Nie używa semaforów ani kolejki - odczyt liczników nie spowalnia systemu.
+ * Kończy się po zamknięciu systemu (flaga 'done') albo po 'liczba' wierszach.
+ *
+ * Użycie:
+ *   ./busstat [interwał_s [liczba]]
+ * Uruchamiany w katalogu programu main (plik klucza bus_shm.key).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "stats.h"
+#include "timescale.h"
+
+#define HEADER_EVERY 20         // Nagłówek co tyle wierszy (jak vmstat)
+
+void print_header() {
+    printf("%7s %7s %7s %7s %7s %7s %7s | %6s %6s %5s\n",
+           "arr/s", "reg/s", "tkt/s", "brd/s", "dep/s", "child/s", "clos/s",
+           "wait", "board", "fill%");
+}
+
+int main(int argc, char** argv) {
+    double interval = argc > 1 ? atof(argv[1]) : 1.0;
+    long count = argc > 2 ? atol(argv[2]) : 0;  // 0 = bez limitu
+    if (interval <= 0) {
+        fprintf(stderr, "Uzycie: %s [interwal_s [liczba]]\n", argv[0]);
+        return 1;
+    }
+
+    // === PODŁĄCZENIE SEGMENTU (TYLKO ODCZYT) ===
+    key_t key = ftok(SHM_PATH, STATS_PROJ);
+    int id = key == -1 ? -1 : shmget(key, 0, 0);
+    if (id == -1) {
+        fprintf(stderr, "busstat: system nie dziala (brak segmentu statystyk)\n");
+        return 1;
+    }
+    const struct BusStats* s = shmat(id, NULL, SHM_RDONLY);
+    if (s == (void*)-1) {
+        perror("shmat");
+        return 1;
+    }
+
+    // === PĘTLA POMIARÓW ===
+    long prev[ST_COUNT];
+    for (int i = 0; i < ST_COUNT; i++) prev[i] = stat_read(s, i);
+    struct timespec next, t0, t1;
+    ts_now(&next);
+    t0 = next;
+    int capacity = s->P * s->platforms;
+
+    for (long row = 0; count == 0 || row < count; row++) {
+        ts_add(&next, interval, 1.0);  // Bezwzględne terminy - bez dryfu
+        int done = __atomic_load_n(&s->done, __ATOMIC_ACQUIRE);
+        if (!done) {
+            while (ts_sleep_until(&next) == EINTR);
+            done = __atomic_load_n(&s->done, __ATOMIC_ACQUIRE);
+        }
+        ts_now(&t1);
+        double dt = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        t0 = t1;
+
+        long cur[ST_COUNT];
+        for (int i = 0; i < ST_COUNT; i++) cur[i] = stat_read(s, i);
+
+        if (row % HEADER_EVERY == 0) print_header();
+        for (int i = 0; i < ST_FIRST_GAUGE; i++) {
+            printf("%7.1f ", dt > 0 ? (cur[i] - prev[i]) / dt : 0.0);
+        }
+        long wait = cur[ST_WAITING] > 0 ? cur[ST_WAITING] : 0;
+        long board = cur[ST_ON_BOARD] > 0 ? cur[ST_ON_BOARD] : 0;
+        printf("| %6ld %6ld %5.0f\n", wait, board, capacity > 0 ? 100.0 * board / capacity : 0.0);
+        fflush(stdout);
+        memcpy(prev, cur, sizeof(prev));
+
+        if (done) break;  // System zakończył pracę - ostatni wiersz wypisany
+    }
+
+    shmdt(s);
+    return 0;
+}
@@ -7,9 +7,30 @@
  * - Wydawanie biletów pasażerom niebędącym VIP i nie będącym dziećmi
  * - Logowanie wszystkich rejestracji do pliku report.txt
  * - Monitorowanie flagi shutdown, aby wiedzieć kiedy zakończyć pracę
+ *
+ * Kasjer nie odpytuje kolejki w pętli: śpi w blokującym msgrcv() i budzi się
+ * gdy przyjdzie rejestracja. Po przebudzeniu odbiera naraz wszystkie
+ * oczekujące rejestracje (do CASHIER_BATCH) i obsługuje je w jednym przebiegu.
+ * Przy shutdown main/dyspozytor wysyłają pustą rejestrację (MSG_WAKEUP_PID).
+ *
+ * Okienek kasy może być kilka (main --cashiers C): wszystkie odbierają z tej
+ * samej kolejki rejestracji, a każde liczy obsłużonych pasażerów we własnym
+ * wpisie bus->window[] (numer okienka w argv[1]).
+ *
+ * Bilet kasa wpisuje do slotu odpowiedzi pasażera (numer slotu przychodzi
+ * w rejestracji, regring.h) i budzi tylko tego pasażera - odpowiedzi nie
+ * wracają przez kolejkę.
+ *
+ * Przy --reg-ring (regring.h) okienko odbiera rejestracje z własnego
+ * pierścienia w pamięci dzielonej. Bez rejestracji śpi na futeksie
+ * pierścienia - budzi je pasażer albo main/dyspozytor przy shutdown
+ * (reg_ring_kick).
  */
 
+#define _DEFAULT_SOURCE  // syscall() - futex slotów odpowiedzi i pierścienia rejestracji (regring.h)
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
@@ -19,68 +40,105 @@
 #include <errno.h>
 #include <string.h>
 #include <time.h>
+#include <signal.h>
+#include <sys/time.h>
 #include "ipc.h"
+#include "logring.h"
+#include "stats.h"
+#include "regring.h"
+
+#define CASHIER_BATCH 64        // Maksymalna liczba rejestracji obsługiwanych w jednym przebiegu
+#define CASHIER_SAFETY_SEC 1    // Okres zapasowego budzenia (gdy shutdown ustawiono bez pobudki)
 
 // Globalne ID zasobów IPC
-int shmid, msgid, semid;
+int shmid, msgid;
 struct BusState* bus;  // Wskaźnik do pamięci dzielonej
+struct LogRing* logring;  // Pierścień logów (NULL = zapis bezpośrednio do pliku)
+struct BusStats* stats;  // Segment statystyk (NULL = brak, stat_add nic nie robi)
+struct RegRing* regring;  // Pierścień rejestracji (NULL = kolejka komunikatów)
+struct ReplyTable* replies;  // Sloty odpowiedzi pasażerów (bilety)
+int window;  // Numer okienka kasy
+int wakeups;  // Odebrane pobudki (MSG_WAKEUP_PID)
 
 /*
- * Funkcja ts (timestamp) - generuje aktualny znacznik czasu
+ * Funkcja log_event - zgłasza zdarzenie do raportu
  * Parametry:
- *   buf - bufor na wynik w formacie HH:MM:SS
- *   n - rozmiar bufora
+ *   e - rekord zdarzenia (czas i PID uzupełniane automatycznie)
+ *
+ * Rekord trafia do pierścienia logów w pamięci dzielonej; bezpośredni
+ * zapis do pliku tylko gdy pierścień jest niedostępny
  */
-void ts(char* buf, size_t n) {
-    time_t t = time(NULL);  // Pobierz aktualny czas systemowy
-    struct tm* tm_info = localtime(&t);  // Konwertuj na czas lokalny
-    if (tm_info == NULL) {
-        snprintf(buf, n, "00:00:00");  // Wartość domyślna w razie błędu
+void log_event(struct EvRecord e) {
+    e.ts_ns = ev_now_ns();
+    if (e.pid == 0) e.pid = getpid();
+    if (logring) {
+        log_ring_push(logring, &e);  // Nie blokuje - zapis wykona logger
         return;
     }
-    strftime(buf, n, "%H:%M:%S", tm_info);  // Formatuj jako HH:MM:SS
+    ev_append(&e, bus->log_binary, bus->clock_offset_ns);
 }
 
 /*
- * Funkcja log_write - zapisuje wpis do pliku report.txt
- * Parametry:
- *   s - tekst do zapisania
- * 
- * Otwiera plik w trybie append, więc nie nadpisuje poprzednich wpisów
+ * Funkcja refuse_pending - odsyła odmowę wszystkim czekającym na bilet
+ * Wywoływana przy shutdown: pasażerowie śpiący na slocie odpowiedzi dostają
+ * odmowę (ticket_ok = 0) i kończą się od razu, bez czekania na limit
  */
-void log_write(const char* s) {
-    int fd = open("report.txt", O_CREAT | O_WRONLY | O_APPEND, 0600);
-    if (fd == -1) return;  // Jeśli nie można otworzyć pliku, po prostu wyjdź
-    write(fd, s, strlen(s));  // Zapisz tekst
-    close(fd);  // Zamknij plik
+void refuse_pending() {
+    struct msg m;
+    if (regring) {
+        while (reg_ring_pop(&regring->q[window], &m, 1, bus->time_scale) == 1) {
+            if (!m.vip && !m.child) reply_complete(replies, m.reply, m.reply_gen, 0, 0);
+        }
+        return;
+    }
+    while (msgrcv(msgid, &m, sizeof(m) - sizeof(long), MSG_REGISTER, IPC_NOWAIT) >= 0) {
+        if (m.pid == MSG_WAKEUP_PID) {
+            wakeups++;
+            continue;
+        }
+        if (m.vip || m.child) continue;  // Nikt nie czeka na odpowiedź
+        reply_complete(replies, m.reply, m.reply_gen, 0, 0);
+    }
 }
 
 /*
- * Funkcja sem_lock - blokuje semafor mutex (sem[0])
- * Używana do zapewnienia wyłącznego dostępu do pamięci dzielonej
+ * Funkcja forward_wakeups - oddaje pobudki przeznaczone dla innych okienek
+ * Jedno okienko może zabrać z kolejki kilka pobudek naraz (odbiór partiami,
+ * refuse_pending); zatrzymuje jedną, resztę odsyła, żeby pozostałe okienka
+ * nie czekały na zapasowy timer
  */
-void sem_lock() {
-    struct sembuf sb = { 0, -1, SEM_UNDO };  // Operacja P (wait) na semaforze 0
-    semop(semid, &sb, 1);  // Wykonaj operację semafora
+void forward_wakeups() {
+    struct msg w;
+    memset(&w, 0, sizeof(w));
+    w.type = MSG_REGISTER;
+    w.pid = MSG_WAKEUP_PID;
+    for (int i = 1; i < wakeups; i++) {
+        msgsnd(msgid, &w, sizeof(w) - sizeof(long), IPC_NOWAIT);
+    }
 }
 
 /*
- * Funkcja sem_unlock - odblokowuje semafor mutex (sem[0])
- * Zwalnia dostęp do pamięci dzielonej
+ * Handler sygnału SIGALRM - zapasowe budzenie kasjera
+ * Nic nie robi: przerywa blokujący msgrcv(), po czym kasjer sprawdza shutdown
  */
-void sem_unlock() {
-    struct sembuf sb = { 0, 1, SEM_UNDO };  // Operacja V (signal) na semaforze 0
-    semop(semid, &sb, 1);  // Wykonaj operację semafora
+void handle_alrm(int sig) {
+    (void)sig;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // === NUMER OKIENKA ===
+    window = argc > 1 ? atoi(argv[1]) : 0;
+    if (window < 0 || window >= MAX_CASHIERS) {
+        fprintf(stderr, "Niepoprawny numer okienka kasy: %d\n", window);
+        return 1;
+    }
+
     // === INICJALIZACJA KLUCZY IPC ===
     // Generowanie kluczy na podstawie ścieżek plików i liter identyfikujących
     key_t shm_key = ftok(SHM_PATH, 'S');  // Klucz dla pamięci dzielonej
     key_t msg_key = ftok(MSG_PATH, 'M');  // Klucz dla kolejki komunikatów
-    key_t sem_key = ftok(SEM_PATH, 'E');  // Klucz dla semaforów
 
-    if (shm_key == -1 || msg_key == -1 || sem_key == -1) {
+    if (shm_key == -1 || msg_key == -1) {
         perror("ftok");
         return 1;
     }
@@ -89,9 +147,8 @@ int main() {
     // Kasjer NIE tworzy zasobów (bez IPC_CREAT), tylko się do nich podłącza
     shmid = shmget(shm_key, sizeof(struct BusState), 0600);  // Pamięć dzielona
     msgid = msgget(msg_key, 0600);  // Kolejka komunikatów
-    semid = semget(sem_key, 4, 0600);  // Zestaw 4 semaforów
 
-    if (shmid == -1 || msgid == -1 || semid == -1) {
+    if (shmid == -1 || msgid == -1) {
         perror("get ipc");
         return 1;
     }
@@ -102,82 +159,120 @@ int main() {
         perror("shmat");
         return 1;
     }
+    logring = log_ring_attach();  // Brak pierścienia nie jest błędem krytycznym
+    stats = stats_attach();  // Tak samo brak segmentu statystyk
+    struct CashierWindow* win = &bus->window[window];  // Liczniki tego okienka
+    replies = reply_table_attach();  // Bez slotów odpowiedzi bilety nie mają dokąd trafić
+    if (!replies) {
+        perror("shmat reply table");
+        return 1;
+    }
+    if (bus->reg_ring) {
+        regring = reg_ring_attach();
+        if (!regring) {
+            perror("shmat reg ring");
+            return 1;
+        }
+    }
 
     // === LOGOWANIE STARTU ===
-    char b[64];  // Bufor na znacznik czasu
-    ts(b, sizeof(b));
-    char ln[128];  // Bufor na linię logu
-    snprintf(ln, sizeof(ln), "[%s] [KASA] Start pracy\n", b);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_CASHIER_START, .arg = window, .passengers = bus->cashiers });
+
+    // === ZAPASOWE BUDZENIE ===
+    // (pierścień rejestracji ma własny limit snu na futeksie - bez timera)
+    // SIGALRM bez SA_RESTART przerywa msgrcv() co CASHIER_SAFETY_SEC sekund.
+    // Normalnie kasjera budzi rejestracja albo pobudka przy shutdown -
+    // timer chroni tylko przed shutdown ustawionym bez wysłania pobudki.
+    struct sigaction saa;
+    memset(&saa, 0, sizeof(saa));
+    saa.sa_handler = handle_alrm;
+    sigemptyset(&saa.sa_mask);
+    saa.sa_flags = 0;
+    sigaction(SIGALRM, &saa, NULL);
+
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    it.it_interval.tv_sec = CASHIER_SAFETY_SEC;
+    it.it_value.tv_sec = CASHIER_SAFETY_SEC;
+    if (!regring) setitimer(ITIMER_REAL, &it, NULL);
 
     // === GŁÓWNA PĘTLA KASJERA ===
-    int no_msg_count = 0;  // Licznik pustych prób odbierania wiadomości
+    struct msg batch[CASHIER_BATCH];  // Rejestracje odebrane w jednym przebiegu
     for (;;) {
-        // NAJPIERW sprawdzamy shutdown PRZED odbieraniem wiadomości
-        // To zapewnia szybkie zakończenie gdy system się wyłącza
-        sem_lock();  // Zablokuj dostęp do pamięci dzielonej
-        int sd = bus->shutdown;  // Odczytaj flagę shutdown
-        sem_unlock();  // Odblokuj dostęp
-
-        if (sd) {
+        // Słowo sterujące czytane bez semafora (bus_control)
+        if (bus_shutting_down(bus)) {
             break;  // Jeśli shutdown=1, kończymy pracę
         }
 
-        // === ODBIERANIE ZGŁOSZENIA REJESTRACYJNEGO ===
-        struct msg m;  // Struktura na komunikat
-        // msgrcv odbiera komunikat typu MSG_REGISTER
-        // IPC_NOWAIT - nie czekaj jeśli brak komunikatów (tryb nieblokujący)
-        ssize_t r = msgrcv(msgid, &m, sizeof(m) - sizeof(long), MSG_REGISTER, IPC_NOWAIT);
-
-        if (r < 0) {
-            if (errno == ENOMSG) {
-                // Brak komunikatów w kolejce - to normalna sytuacja
-                no_msg_count++;
-
-                // Jeśli przez dłuższy czas brak komunikatów, zaśnij na chwilę
-                // To zmniejsza zużycie CPU podczas bezczynności
-                if (no_msg_count > 100) {
-                    sleep(1);
-                    no_msg_count = 0;
-                }
-                continue;  // Sprawdź ponownie
+        // === ODBIERANIE ZGŁOSZEŃ REJESTRACYJNYCH ===
+        int n;
+        if (regring) {
+            // Pierścień okienka: wszystko co czeka (do CASHIER_BATCH), bez wywołań systemowych
+            n = reg_ring_pop(&regring->q[window], batch, CASHIER_BATCH, bus->time_scale);
+            if (n == 0) {
+                reg_ring_sleep(&regring->q[window], CASHIER_SAFETY_SEC, 1.0);
+                continue;  // Rejestracja, pobudka albo limit - sprawdź shutdown
             }
-            else {
-                // Inny błąd niż ENOMSG
+        }
+        else {
+            // Pierwsza rejestracja: czekamy (blokująco) aż się pojawi
+            ssize_t r = msgrcv(msgid, &batch[0], sizeof(batch[0]) - sizeof(long), MSG_REGISTER, 0);
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;  // Zapasowe budzenie - sprawdź shutdown
+                }
                 perror("msgrcv");
                 break;
             }
-        }
 
-        // === ODEBRALIŚMY KOMUNIKAT ===
-        no_msg_count = 0;  // Resetuj licznik
+            // Kolejne rejestracje: zabieramy wszystko co już czeka (bez blokowania)
+            n = 1;
+            while (n < CASHIER_BATCH &&
+                   msgrcv(msgid, &batch[n], sizeof(batch[n]) - sizeof(long), MSG_REGISTER, IPC_NOWAIT) >= 0) {
+                n++;
+            }
+        }
 
-        // Loguj rejestrację pasażera
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [KASA] Rejestracja PID=%d VIP=%d DZIECKO=%d\n",
-                 b, m.pid, m.vip, m.child);
-        log_write(ln);
+        // === LOGOWANIE REJESTRACJI ===
+        uint64_t now = ev_now_ns();  // Jeden odczyt zegara na całą paczkę
+        for (int i = 0; i < n; i++) {
+            struct msg* m = &batch[i];
+            if (m->pid == MSG_WAKEUP_PID) {
+                wakeups++;  // Pobudka - nie jest rejestracją
+                continue;
+            }
+            win->registrations++;
+            stat_add(stats, ST_REGISTRATIONS, 1);
+            m->reg_ns = now;  // Wraca do pasażera w odpowiedzi (rejestracja→bilet)
+            if (!m->child && m->arrive_ns != 0 && m->arrive_ns <= now) {
+                hist_add(&bus->hist, HIST_ARRIVE_REG, hist_class(m->vip, m->bike, m->family), now - m->arrive_ns);
+            }
+            log_event((struct EvRecord){ .type = EV_CASHIER_REGISTER, .arg = m->pid, .arg2 = window, .passengers = bus->cashiers, .vip = m->vip, .child = m->child });
+        }
 
         // === WYDAWANIE BILETÓW ===
         // Wysyłamy bilet tylko dla nie-VIP dorosłych (nie dzieci)
         // VIP nie potrzebują biletów (darmowy przejazd)
         // Dzieci wchodzą z rodzicem i nie dostają osobnych biletów
-        if (!m.vip && !m.child) {
-            m.ticket_ok = 1;  // Ustaw flagę "bilet OK"
-            m.type = MSG_TICKET_REPLY + m.pid;  // Typ wiadomości = MSG_TICKET_REPLY + PID pasażera
-            // Wysyłanie biletu do pasażera
-            if (msgsnd(msgid, &m, sizeof(m) - sizeof(long), 0) == -1) {
-                perror("msgsnd reply");
+        for (int i = 0; i < n; i++) {
+            struct msg* m = &batch[i];
+            if (m->pid == MSG_WAKEUP_PID || m->vip || m->child) continue;
+            // Bilet do slotu odpowiedzi pasażera; -1 = pasażer już zrezygnował (shutdown)
+            if (reply_complete(replies, m->reply, m->reply_gen, 1, m->reg_ns) == -1) {
+                continue;
             }
+            win->tickets++;
+            stat_add(stats, ST_TICKETS, 1);
         }
-        // VIP i dzieci nie dostają osobnych biletów (dzieci wchodzą z rodzicem)
     }
 
     // === ZAKOŃCZENIE PRACY ===
-    ts(b, sizeof(b));
-    snprintf(ln, sizeof(ln), "[%s] [KASA] Koniec pracy\n", b);
-    log_write(ln);
+    refuse_pending();  // Obudź pasażerów czekających na bilet
+    forward_wakeups();  // Obudź pozostałe okienka
+    log_event((struct EvRecord){ .type = EV_CASHIER_END, .arg = window, .passengers = bus->cashiers });
 
+    if (regring) shmdt(regring);
+    shmdt(replies);
     shmdt(bus);  // Odłącz pamięć dzieloną
     return 0;
 }
@@ -6,54 +6,80 @@
  * - Wymuszanie odjazdu autobusu (sygnał SIGUSR1)
  * - Blokowanie dworca i zamykanie systemu (sygnał SIGUSR2)
  * - Obsługa przerwania SIGINT (Ctrl+C)
+ * - Zmienny postój (--adaptive-dwell MIN:MAX): co sekundę modelu odczyt
+ *   liczników popytu (przybycia z generatora, poczekalnia), wygładzenie
+ *   EWMA i nowy postój T w granicach MIN..MAX (policy.h)
  * 
- * Dyspozytor nie wykonuje aktywnych operacji - działa reaktywnie,
- * reagując tylko na otrzymane sygnały.
+ * Bez --adaptive-dwell dyspozytor nie wykonuje aktywnych operacji - działa
+ * reaktywnie, reagując tylko na otrzymane sygnały.
  */
 
+#define _DEFAULT_SOURCE  // syscall() - pobudka kasy na futeksie pierścienia rejestracji (regring.h)
+
 #include <stdio.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/msg.h>
+#include <sys/sem.h>
 #include <fcntl.h>
 #include <string.h>
 #include <time.h>
 #include "ipc.h"
+#include "logring.h"
+#include "stats.h"
+#include "timescale.h"
+#include "policy.h"
+#include "regring.h"
 
 // Globalne zmienne
 int shmid;  // ID pamięci dzielonej
+int msgid = -1;  // ID kolejki komunikatów (tylko do budzenia kasjera)
+int semid = -1;  // ID zestawu semaforów (tylko dzwonki stanowisk przy wymuszonym odjeździe)
 struct BusState* bus;  // Wskaźnik do stanu systemu
+struct LogRing* logring;  // Pierścień logów (NULL = zapis bezpośrednio do pliku)
+struct BusStats* stats;  // Segment statystyk - źródło pomiarów popytu (NULL = brak)
+struct RegRing* regring;  // Pierścień rejestracji (--reg-ring) - tylko do budzenia kasy
 volatile sig_atomic_t should_exit = 0;  // Flaga zakończenia (volatile - może być zmieniana w handlerze)
 
 /*
- * Funkcja ts (timestamp) - generuje aktualny znacznik czasu
+ * Funkcja log_event - zgłasza zdarzenie do raportu
  * Parametry:
- *   buf - bufor na wynik w formacie HH:MM:SS
- *   n - rozmiar bufora
+ *   e - rekord zdarzenia (czas i PID uzupełniane automatycznie)
+ *
+ * Rekord trafia do pierścienia logów w pamięci dzielonej; bezpośredni
+ * zapis do pliku tylko gdy pierścień jest niedostępny
  */
-void ts(char* buf, size_t n) {
-    time_t t = time(NULL);  // Pobierz aktualny czas systemowy
-    struct tm* tm_info = localtime(&t);  // Konwertuj na czas lokalny
-    if (tm_info == NULL) {
-        snprintf(buf, n, "00:00:00");  // Wartość domyślna w razie błędu
+void log_event(struct EvRecord e) {
+    e.ts_ns = ev_now_ns();
+    if (e.pid == 0) e.pid = getpid();
+    if (logring) {
+        log_ring_push(logring, &e);  // Nie blokuje - zapis wykona logger
         return;
     }
-    strftime(buf, n, "%H:%M:%S", tm_info);  // Formatuj jako HH:MM:SS
+    ev_append(&e, bus->log_binary, bus->clock_offset_ns);
 }
 
 /*
- * Funkcja log_write - zapisuje wpis do pliku report.txt
- * Parametry:
- *   s - tekst do zapisania
- * 
- * Otwiera plik w trybie append, więc nie nadpisuje poprzednich wpisów
+ * Funkcja wake_cashiers - budzi okienka kasy śpiące w blokującym msgrcv()
+ * Wysyła po jednej pustej rejestracji (pid = MSG_WAKEUP_PID) na okienko;
+ * IPC_NOWAIT, bo wołana z handlera sygnału - przy pełnej kolejce kasjerzy
+ * i tak są zajęci. Przy --reg-ring okienka śpią na futeksie pierścienia.
  */
-void log_write(const char* s) {
-    int fd = open("report.txt", O_CREAT | O_WRONLY | O_APPEND, 0600);
-    if (fd == -1) return;  // Jeśli nie można otworzyć pliku, po prostu wyjdź
-    write(fd, s, strlen(s));  // Zapisz tekst
-    close(fd);  // Zamknij plik
+void wake_cashiers() {
+    if (regring) {
+        reg_ring_kick(regring, bus->cashiers);
+        return;
+    }
+    if (msgid == -1) return;
+    struct msg w;
+    memset(&w, 0, sizeof(w));
+    w.type = MSG_REGISTER;
+    w.pid = MSG_WAKEUP_PID;
+    for (int i = 0; i < bus->cashiers; i++) {
+        msgsnd(msgid, &w, sizeof(w) - sizeof(long), IPC_NOWAIT);
+    }
 }
 
 /*
@@ -69,19 +95,28 @@ void handle_int(int sig) {
  * Handler sygnału SIGUSR1 - wymuszenie odjazdu autobusu
  * 
  * Gdy dyspozytor otrzyma SIGUSR1:
- * 1. Sprawdza czy jakiś kierowca jest aktualnie na dworcu (bus->driver_pid > 0)
- * 2. Jeśli tak, wysyła do niego sygnał SIGUSR1
+ * 1. Sprawdza na których stanowiskach stoją kierowcy (platform[i].driver_pid > 0)
+ * 2. Każdemu z nich wysyła sygnał SIGUSR1 i dzwoni na jego stanowisku
+ *    (SEM_DWELL + i)
  * 3. Kierowca otrzymując ten sygnał natychmiast odjeżdża (nie czekając T sekund)
+ *
+ * Dzwonek zostaje w semaforze: sygnał, który trafi między sprawdzeniem
+ * force_flag a semtimedop() kierowcy, nie przerwie snu, ale semtimedop()
+ * wróci od razu i kierowca zobaczy ustawioną flagę.
  */
 void handle_usr1(int sig) {
     (void)sig;  // Nie używamy parametru
-    if (bus && bus->driver_pid > 0) {
-        kill(bus->driver_pid, SIGUSR1);  // Wyślij SIGUSR1 do kierowcy
-        char b[64];
-        ts(b, sizeof(b));
-        char ln[128];
-        snprintf(ln, sizeof(ln), "[%s] [DYSPOZYTOR] Wymuszenie odjazdu\n", b);
-        log_write(ln);
+    if (!bus) return;
+    for (int i = 0; i < bus->platforms; i++) {
+        pid_t d = bus->platform[i].driver_pid;
+        if (d > 0) {
+            kill(d, SIGUSR1);  // Wyślij SIGUSR1 do kierowcy
+            if (semid != -1) {
+                struct sembuf sb = { SEM_DWELL + i, 1, 0 };
+                semop(semid, &sb, 1);  // Dzwonek - kierowca nie zaśnie na pełny postój
+            }
+            log_event((struct EvRecord){ .type = EV_DISPATCHER_FORCE, .arg = i });
+        }
     }
 }
 
@@ -89,28 +124,66 @@ void handle_usr1(int sig) {
  * Handler sygnału SIGUSR2 - blokada dworca i zamknięcie systemu
  * 
  * Gdy dyspozytor otrzyma SIGUSR2:
- * 1. Ustawia flagę station_blocked (nowi pasażerowie nie mogą wejść)
- * 2. Ustawia flagę shutdown (cały system zaczyna się wyłączać)
- * 3. Wysyła SIGUSR2 do kierowcy (jeśli jest na dworcu)
+ * 1-2. Ustawia w słowie sterującym blokadę dworca (nowi pasażerowie nie
+ *      mogą wejść) i shutdown (cały system zaczyna się wyłączać)
+ * 3. Wysyła SIGUSR2 do kierowców na stanowiskach i budzi kasjerów
  * 4. Ustawia flagę should_exit aby zakończyć proces dyspozytora
  */
 void handle_usr2(int sig) {
     (void)sig;  // Nie używamy parametru
     if (bus) {
-        bus->station_blocked = 1;  // Zablokuj dworzec
-        bus->shutdown = 1;  // Rozpocznij wyłączanie systemu
-        if (bus->driver_pid > 0) {
-            kill(bus->driver_pid, SIGUSR2);  // Powiadom kierowcę
+        bus_control_set(bus, CTRL_BLOCKED | CTRL_SHUTDOWN);  // Zablokuj dworzec i rozpocznij wyłączanie
+        for (int i = 0; i < bus->platforms; i++) {
+            if (bus->platform[i].driver_pid > 0) {
+                kill(bus->platform[i].driver_pid, SIGUSR2);  // Powiadom kierowcę
+            }
         }
-        char b[64];
-        ts(b, sizeof(b));
-        char ln[128];
-        snprintf(ln, sizeof(ln), "[%s] [DYSPOZYTOR] Blokada dworca\n", b);
-        log_write(ln);
+        wake_cashiers();  // Kasjerzy śpią w msgrcv() - niech sprawdzą shutdown
+        log_event((struct EvRecord){ .type = EV_DISPATCHER_BLOCK });
     }
     should_exit = 1;  // Zakończ proces dyspozytora
 }
 
+/*
+ * Funkcja adapt_dwell - pętla zmiennego postoju (--adaptive-dwell)
+ *
+ * Co DWELL_TICK sekund modelu: przyrost licznika przybyć i stan poczekalni
+ * z segmentu statystyk trafiają do estymatora EWMA, a wyznaczony postój
+ * (dwell_target) zapisujemy w BusState - kierowcy biorą go przy kolejnej
+ * decyzji o odjeździe. Każda zmiana trafia do raportu (EV_DISPATCHER_DWELL).
+ * Sygnały przerywają sen (EINTR) - obsługa i powrót do tego samego terminu.
+ */
+void adapt_dwell() {
+    struct DwellEstimator est = { 0 };
+    int buses = bus->N < bus->platforms ? bus->N : bus->platforms;  // Autobusy naraz na dworcu
+    long prev = stat_read(stats, ST_ARRIVALS);
+    struct timespec next, t0, t1;
+    ts_now(&next);
+    t0 = next;
+    while (!should_exit) {
+        ts_add(&next, DWELL_TICK, bus->time_scale);
+        while (!should_exit && ts_sleep_until(&next) == EINTR);
+        if (should_exit) break;
+
+        ts_now(&t1);
+        double dt = ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9) * bus->time_scale;
+        t0 = t1;
+        long cur = stat_read(stats, ST_ARRIVALS);
+        long waiting = stat_read(stats, ST_WAITING);
+        dwell_observe(&est, cur - prev, dt, waiting > 0 ? waiting : 0);
+        prev = cur;
+
+        int old = __atomic_load_n(&bus->dwell_ms, __ATOMIC_RELAXED);
+        int ms = dwell_target(&est, bus->P, buses, bus->dwell_min, bus->dwell_max, old);
+        if (ms != old) {
+            __atomic_store_n(&bus->dwell_ms, ms, __ATOMIC_RELAXED);
+            log_event((struct EvRecord){ .type = EV_DISPATCHER_DWELL, .arg = ms,
+                                         .arg2 = (int)(est.rate * 1000.0 + 0.5),
+                                         .passengers = (int16_t)(est.queue < 32767 ? est.queue + 0.5 : 32767) });
+        }
+    }
+}
+
 int main() {
     // === INICJALIZACJA KLUCZA IPC ===
     key_t shm_key = ftok(SHM_PATH, 'S');  // Generuj klucz dla pamięci dzielonej
@@ -133,13 +206,25 @@ int main() {
         perror("shmat");
         return 1;
     }
+    logring = log_ring_attach();  // Brak pierścienia nie jest błędem krytycznym
+    stats = stats_attach();
+
+    // Kolejka komunikatów - potrzebna tylko do pobudki kasjera przy SIGUSR2
+    key_t msg_key = ftok(MSG_PATH, 'M');
+    if (msg_key != -1) {
+        msgid = msgget(msg_key, 0600);
+    }
+    // Semafory - dzwonki stanowisk przy wymuszonym odjeździe (SIGUSR1)
+    key_t sem_key = ftok(SEM_PATH, 'E');
+    if (sem_key != -1) {
+        semid = semget(sem_key, SEM_COUNT, 0600);
+    }
+    if (bus->reg_ring) {
+        regring = reg_ring_attach();  // Bez niego kasę obudzi jej zapasowy limit snu
+    }
 
     // === LOGOWANIE STARTU ===
-    char b[64];
-    ts(b, sizeof(b));
-    char ln[128];
-    snprintf(ln, sizeof(ln), "[%s] [DYSPOZYTOR] Start pracy\n", b);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_DISPATCHER_START });
 
     // === KONFIGURACJA HANDLERA SIGINT ===
     struct sigaction sai;
@@ -166,6 +251,15 @@ int main() {
     sigaction(SIGUSR2, &sa2, NULL);  // Zarejestruj handler
 
     // === GŁÓWNA PĘTLA DYSPOZYTORA ===
+    if (bus->dwell_max > 0) {
+        if (stats) {
+            adapt_dwell();  // Pomiary popytu co sekundę modelu, sygnały jak niżej
+        }
+        else {
+            // main sprawdza segment przy starcie - tu trafiamy tylko gdy podłączenie się nie udało
+            fprintf(stderr, "DYSPOZYTOR: brak segmentu statystyk - --adaptive-dwell wylaczone, staly postoj T\n");
+        }
+    }
     // Proces czeka na sygnały używając pause()
     // pause() zawiesza proces do otrzymania sygnału
     while (!should_exit) {
@@ -173,10 +267,9 @@ int main() {
     }
 
     // === ZAKOŃCZENIE PRACY ===
-    ts(b, sizeof(b));
-    snprintf(ln, sizeof(ln), "[%s] [DYSPOZYTOR] Koniec pracy\n", b);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_DISPATCHER_END });
 
+    if (regring) shmdt(regring);
     shmdt(bus);  // Odłącz pamięć dzieloną
     return 0;
 }
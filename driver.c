@@ -4,17 +4,25 @@
  * Ten proces symuluje kierowcę autobusu. Każdy autobus ma swojego kierowcę.
  * Główne zadania:
  * - Przybywanie na dworzec i czekanie T sekund (lub na sygnał od dyspozytora)
- * - Odbieranie pasażerów (pasażerowie sami wchodzą przez bramki)
+ * - Odbieranie pasażerów (pasażerowie sami wchodzą - CAS na słowie wsiadania)
  * - Odjazd z pasażerami
  * - Podróż trwająca losowo 3-9 sekund
  * - Powrót na dworzec i powtórzenie cyklu
  * 
  * Synchronizacja:
- * - Semafor gate[3] zapewnia że tylko jeden autobus jest na dworcu
- * - Semafory gate[1] i gate[2] kontrolują dostęp pasażerów
- * - Flaga departing informuje pasażerów że autobus zaraz odjeżdża
+ * - Semafor SEM_STATION (zliczający) - na dworcu stoi najwyżej tyle autobusów,
+ *   ile jest stanowisk; każdy kierowca zajmuje własne stanowisko
+ * - Słowo wsiadania stanowiska (liczniki + flaga odjazdu) zmieniane atomowo -
+ *   kierowca zamyka drzwi jednym atomowym ustawieniem BOARD_DEPARTING
+ * - Semafory poczekalni (SEM_ROOM, SEM_ROOM_BIKE) - po przyjeździe kierowca
+ *   budzi tylu czekających pasażerów, ilu zmieści się w autobusie
+ * - Dzwonek stanowiska (SEM_DWELL + i) - postój to czekanie z limitem wyznaczonym
+ *   przez zasadę odjazdu (policy.h), które przerywa pasażer zapełniający autobus
+ *   (lub osiągający próg zasady), shutdown albo sygnał dyspozytora
  */
 
+#define _GNU_SOURCE  // semtimedop() - czekanie na semaforze z limitem czasu; syscall() (logring.h)
+
 #include <stdio.h>
 #include <unistd.h>
 #include <signal.h>
@@ -24,68 +32,65 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
 #include <time.h>
 #include <stdlib.h>
 #include "ipc.h"
+#include "logring.h"
+#include "stats.h"
+#include "buslock.h"
+#include "timescale.h"
+#include "rng.h"
+#include "policy.h"
 
 // Globalne zmienne
 int shmid, semid;  // ID zasobów IPC
 struct BusState* bus;  // Wskaźnik do stanu systemu
+struct LogRing* logring;  // Pierścień logów (NULL = zapis bezpośrednio do pliku)
+struct BusStats* stats;  // Segment statystyk (NULL = brak, stat_add nic nie robi)
 volatile sig_atomic_t force_flag = 0;  // Flaga wymuszonego odjazdu
+struct Rng rng;  // Strumień losowy kierowcy (czasy podróży)
 
 /*
- * Funkcja ts (timestamp) - generuje aktualny znacznik czasu
+ * Funkcja log_event - zgłasza zdarzenie do raportu
  * Parametry:
- *   buf - bufor na wynik w formacie HH:MM:SS
- *   n - rozmiar bufora
+ *   e - rekord zdarzenia (czas i PID uzupełniane automatycznie)
+ *
+ * Rekord trafia do pierścienia logów w pamięci dzielonej; bezpośredni
+ * zapis do pliku tylko gdy pierścień jest niedostępny
  */
-void ts(char* buf, size_t n) {
-    time_t t = time(NULL);  // Pobierz aktualny czas systemowy
-    struct tm* tm_info = localtime(&t);  // Konwertuj na czas lokalny
-    if (tm_info == NULL) {
-        snprintf(buf, n, "00:00:00");  // Wartość domyślna w razie błędu
+void log_event(struct EvRecord e) {
+    e.ts_ns = ev_now_ns();
+    if (e.pid == 0) e.pid = getpid();
+    if (logring) {
+        log_ring_push(logring, &e);  // Nie blokuje - zapis wykona logger
         return;
     }
-    strftime(buf, n, "%H:%M:%S", tm_info);  // Formatuj jako HH:MM:SS
-}
-
-/*
- * Funkcja log_write - zapisuje wpis do pliku report.txt
- * Parametry:
- *   s - tekst do zapisania
- */
-void log_write(const char* s) {
-    int fd = open("report.txt", O_CREAT | O_WRONLY | O_APPEND, 0600);
-    if (fd == -1) return;
-    write(fd, s, strlen(s));
-    close(fd);
+    ev_append(&e, bus->log_binary, bus->clock_offset_ns);
 }
 
 /*
- * Funkcja sem_lock - blokuje semafor mutex (sem[0])
+ * Funkcja sem_lock - blokuje mutex BusState (semafor sem[0] lub futex, buslock.h)
  * Używana do zapewnienia wyłącznego dostępu do pamięci dzielonej
  */
 void sem_lock() {
-    struct sembuf sb = { 0, -1, SEM_UNDO };  // Operacja P (wait) na semaforze 0
-    semop(semid, &sb, 1);
+    bus_lock(bus, semid);  // Semafor SysV albo futex - patrz buslock.h
 }
 
 /*
- * Funkcja sem_unlock - odblokowuje semafor mutex (sem[0])
+ * Funkcja sem_unlock - odblokowuje mutex BusState
  */
 void sem_unlock() {
-    struct sembuf sb = { 0, 1, SEM_UNDO };  // Operacja V (signal) na semaforze 0
-    semop(semid, &sb, 1);
+    bus_unlock(bus, semid);
 }
 
 /*
- * Funkcja gate_lock - blokuje określoną bramkę
+ * Funkcja gate_lock - zajmuje semafor zliczający z SEM_UNDO
  * Parametry:
- *   gate - numer bramki (1 = bez roweru, 2 = z rowerem, 3 = dworzec)
+ *   gate - numer semafora (SEM_STATION = wolne stanowiska na dworcu)
  * 
- * Używana przez kierowcę do:
- * - Zablokowania dworca (gate=3) przed wjazdem
- * - Zablokowania wejść pasażerów (gate=1, gate=2) przed odjazdem
+ * Używana przez kierowcę przed wjazdem na dworzec.
+ * Wejść pasażerów nie blokujemy - drzwi zamyka flaga BOARD_DEPARTING.
  */
 void gate_lock(int gate) {
     struct sembuf sb = { gate, -1, SEM_UNDO };  // Operacja P na semaforze 'gate'
@@ -93,15 +98,132 @@ void gate_lock(int gate) {
 }
 
 /*
- * Funkcja gate_unlock - odblokowuje określoną bramkę
+ * Funkcja gate_unlock - zwalnia semafor zajęty przez gate_lock
  * Parametry:
- *   gate - numer bramki
+ *   gate - numer semafora
  */
 void gate_unlock(int gate) {
     struct sembuf sb = { gate, 1, SEM_UNDO };  // Operacja V na semaforze 'gate'
     semop(semid, &sb, 1);
 }
 
+/*
+ * Funkcja room_post - budzi n pasażerów z poczekalni
+ * Bez SEM_UNDO - to sygnał dla innych procesów, nie blokada kierowcy.
+ * sem_op jest typu short: więcej niż SHRT_MAX (shutdown - wake_all)
+ * podnosimy porcjami, jak main.c room_post().
+ */
+void room_post(int room, int n) {
+    while (n > 0) {  // sem_op = 0 oznaczałoby "czekaj na zero"
+        short op = n > SHRT_MAX ? SHRT_MAX : (short)n;
+        struct sembuf sb = { room, op, 0 };
+        if (semop(semid, &sb, 1) == -1) return;
+        n -= op;
+    }
+}
+
+/*
+ * Funkcja wake_waiting - budzi pasażerów z poczekalni (wołana pod mutexem)
+ * Parametry:
+ *   st - stanowisko, na które właśnie przyjechał autobus
+ *
+ * Budzi tylu, ilu zmieści się w autobusie: najpierw pasażerów z rowerem
+ * (ograniczają ich miejsca na rowery), potem resztę na pozostałe miejsca.
+ * Rodzic z dzieckiem potrzebuje 2 miejsc - jeśli się nie zmieści,
+ * wraca do poczekalni.
+ */
+void wake_waiting(struct Platform* st) {
+    unsigned long long w = __atomic_load_n(&st->board, __ATOMIC_ACQUIRE);
+    int seats = bus->P - BOARD_PASSENGERS(w);  // Wolne miejsca
+    int bikes = bus->R - BOARD_BIKES(w);  // Wolne miejsca na rowery
+
+    int kb = bus->waiting_bikes;
+    if (kb > bikes) kb = bikes;
+    if (kb > seats) kb = seats;
+    if (kb < 0) kb = 0;
+    seats -= kb;
+
+    int kn = bus->waiting;
+    if (kn > seats) kn = seats;
+    if (kn < 0) kn = 0;
+
+    bus->waiting_bikes -= kb;
+    bus->waiting -= kn;
+    room_post(SEM_ROOM_BIKE, kb);
+    room_post(SEM_ROOM, kn);
+}
+
+/*
+ * Funkcja dwell - postój na stanowisku
+ * Parametry:
+ *   pl - numer stanowiska
+ *   arrive_ns - czas przyjazdu na stanowisko (ev_now_ns)
+ *
+ * O odjeździe decyduje zasada (--policy, policy_decide). Dopóki każe czekać,
+ * kierowca czeka na dzwonku stanowiska najwyżej tyle, ile zwróciła, i pyta
+ * ponownie. Dzwoni pasażer, którego CAS zapełnił autobus albo przekroczył
+ * próg zasady (policy_ring_load), oraz main przy shutdown.
+ * Wraca od razu, gdy:
+ * - system się wyłącza (dzwoni main; dyspozytor wysyła SIGUSR2),
+ * - dyspozytor wymusił odjazd (SIGUSR1 - semtimedop() przerwany sygnałem
+ *   zawsze zwraca EINTR, niezależnie od SA_RESTART; dyspozytor dzwoni też
+ *   na stanowisku, więc sygnał między sprawdzeniem force_flag a
+ *   semtimedop() nie przepada - semtimedop() wraca od razu).
+ * Flagi i liczniki czytamy atomowo - bez semafora 0.
+ */
+void dwell(int pl, unsigned long long arrive_ns) {
+    struct Platform* st = &bus->platform[pl];
+    double scale = bus->time_scale;
+    for (;;) {
+        if (force_flag || bus_closed(bus)) {
+            return;
+        }
+        unsigned long long w = __atomic_load_n(&st->board, __ATOMIC_ACQUIRE);
+        unsigned long long last = __atomic_load_n(&bus->last_depart_ns, __ATOMIC_ACQUIRE);
+        unsigned long long now = ev_now_ns();
+        double waited = (now - arrive_ns) / 1e9 * scale;  // Sekundy modelu
+        double since = last ? (now > last ? now - last : 0) / 1e9 * scale : -1.0;
+        double wait_more;
+        double T = __atomic_load_n(&bus->dwell_ms, __ATOMIC_RELAXED) / 1000.0;  // Zmienia dyspozytor
+        if (policy_decide(bus->policy, bus->policy_arg, bus->N, bus->P, bus->R, T,
+                          BOARD_PASSENGERS(w), BOARD_BIKES(w), waited, since, &wait_more)) {
+            return;  // Odjazd
+        }
+        // Czekanie względne - po dzwonku, sygnale czy upływie limitu decyzja
+        // zapada od nowa na podstawie czasów bezwzględnych, więc nic się nie sumuje
+        double rel = wait_more / scale;
+        struct timespec left;
+        left.tv_sec = (time_t)rel;
+        left.tv_nsec = (long)((rel - left.tv_sec) * 1e9);
+        struct sembuf sb = { SEM_DWELL + pl, -1, 0 };
+        semtimedop(semid, &sb, 1, &left);
+    }
+}
+
+/*
+ * Funkcja release_platform - autobus opuszcza stanowisko
+ * Liczniki zerujemy, drzwi zostają zamknięte do przyjazdu następnego
+ * autobusu, a stanowisko wraca do puli wolnych (semafor SEM_STATION)
+ */
+void release_platform(struct Platform* st) {
+    unsigned long long w = __atomic_exchange_n(&st->board, BOARD_DEPARTING, __ATOMIC_ACQ_REL);
+    stat_add(stats, ST_ON_BOARD, -(long)BOARD_PASSENGERS(w));  // Pasażerowie opuszczają stanowisko
+    sem_lock();
+    st->driver_pid = 0;  // Stanowisko wolne
+    sem_unlock();
+    gate_unlock(SEM_STATION);
+}
+
+/*
+ * Funkcja wake_all - budzi wszystkich z poczekalni (shutdown, wołana pod mutexem)
+ */
+void wake_all() {
+    room_post(SEM_ROOM_BIKE, bus->waiting_bikes);
+    room_post(SEM_ROOM, bus->waiting);
+    bus->waiting_bikes = 0;
+    bus->waiting = 0;
+}
+
 /*
  * Handler sygnału SIGUSR1 - wymuszony odjazd
  * Dyspozytor wysyła ten sygnał aby zmusić autobus do natychmiastowego odjazdu
@@ -118,9 +240,7 @@ void handle_usr1(int sig) {
  */
 void handle_usr2(int sig) {
     (void)sig;
-    sem_lock();
-    bus->station_blocked = 1;  // Ustaw flagę blokady dworca
-    sem_unlock();
+    bus_control_set(bus, CTRL_BLOCKED);  // Ustaw flagę blokady dworca (atomowo, bez mutexu)
 }
 
 /*
@@ -128,13 +248,10 @@ void handle_usr2(int sig) {
  */
 void handle_int(int sig) {
     (void)sig;
-    sem_lock();
-    bus->shutdown = 1;  // Rozpocznij wyłączanie
-    bus->station_blocked = 1;  // Zablokuj dworzec
-    sem_unlock();
+    bus_control_set(bus, CTRL_SHUTDOWN | CTRL_BLOCKED);  // Rozpocznij wyłączanie i zablokuj dworzec
 }
 
-int main() {
+int main(int argc, char** argv) {
     // === INICJALIZACJA KLUCZY IPC ===
     key_t shm_key = ftok(SHM_PATH, 'S');  // Klucz pamięci dzielonej
     key_t sem_key = ftok(SEM_PATH, 'E');  // Klucz semaforów
@@ -146,7 +263,7 @@ int main() {
 
     // === UZYSKANIE DOSTĘPU DO ZASOBÓW IPC ===
     shmid = shmget(shm_key, sizeof(struct BusState), 0600);
-    semid = semget(sem_key, 4, 0600);
+    semid = semget(sem_key, SEM_COUNT, 0600);
 
     if (shmid == -1 || semid == -1) {
         perror("get ipc");
@@ -159,6 +276,8 @@ int main() {
         perror("shmat");
         return 1;
     }
+    logring = log_ring_attach();  // Brak pierścienia nie jest błędem krytycznym
+    stats = stats_attach();  // Tak samo brak segmentu statystyk
 
     // === KONFIGURACJA HANDLERÓW SYGNAŁÓW ===
     
@@ -187,143 +306,125 @@ int main() {
     sigaction(SIGINT, &sai, NULL);
 
     // === INICJALIZACJA GENERATORA LICZB LOSOWYCH ===
-    // Używamy PID i czasu aby każdy kierowca miał inne losowe czasy podróży
-    srand((unsigned)(getpid() ^ time(NULL)));
+    // Strumień wyznacza ziarno przebiegu i numer kierowcy (argv[1]), nie PID -
+    // ten sam --seed daje te same czasy podróży
+    int index = argc > 1 ? atoi(argv[1]) : 0;  // Numer kierowcy 0..N-1
+    rng_init(&rng, bus->seed, RNG_DRIVER, (uint32_t)index);
 
     // === LOGOWANIE STARTU ===
-    char b[64];
-    ts(b, sizeof(b));
-    char ln[128];
-    snprintf(ln, sizeof(ln), "[%s] [KIEROWCA %d] Start pracy\n", b, getpid());
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_DRIVER_START });
 
     // === GŁÓWNA PĘTLA KIEROWCY ===
     for (;;) {
         // === FAZA 1: PRZYBYCIE NA DWORZEC ===
-        // Tylko jeden autobus na dworcu - gate[3]
-        // Semafor gate[3] zapewnia że tylko jeden autobus może być na dworcu
-        gate_lock(3);
+        // Semafor SEM_STATION liczy wolne stanowiska - czekamy aż któreś się zwolni
+        gate_lock(SEM_STATION);
 
-        // Zapisz swój PID jako aktualny kierowca i zresetuj flagę departing
+        // Zajmij wolne stanowisko i otwórz drzwi (pusty autobus)
         sem_lock();
-        // Sprawdzamy czy nie ma już innego kierowcy (ochrona przed CTRL+Z)
-        if (bus->driver_pid != 0 && bus->driver_pid != getpid()) {
-            int sd_tmp = bus->shutdown;
-            int sb_tmp = bus->station_blocked;
+        int pl = -1;  // Numer naszego stanowiska
+        for (int i = 0; i < bus->platforms; i++) {
+            if (bus->platform[i].driver_pid == 0) {
+                pl = i;
+                break;
+            }
+        }
+        // Brak wolnego stanowiska mimo semafora (np. kierowca zatrzymany CTRL+Z
+        // nie zwolnił jeszcze stanowiska) - spróbuj ponownie za chwilę
+        if (pl == -1) {
             sem_unlock();
-            gate_unlock(3);
+            gate_unlock(SEM_STATION);
 
             // Jeśli shutdown - kończymy od razu
-            if (sd_tmp || sb_tmp) {
+            if (bus_closed(bus)) {
                 break;
             }
 
-            sleep(1);
+            ts_sleep(1, bus->time_scale);
             continue;
         }
-        bus->driver_pid = getpid();  // Zapisz PID kierowcy
-        bus->departing = 0;  // Autobus jeszcze nie odjeżdża
-        int sb = bus->station_blocked;  // Odczytaj flagę blokady
-        int sd = bus->shutdown;  // Odczytaj flagę shutdown
-        int wait_time = bus->T;  // Odczytaj czas oczekiwania
+        struct Platform* st = &bus->platform[pl];  // Nasze stanowisko
+        st->driver_pid = getpid();  // Zapisz PID kierowcy
+        semctl(semid, SEM_DWELL + pl, SETVAL, 0);  // Dzwonek poprzedniego autobusu nieaktualny
+        force_flag = 0;  // Wymuszenie dotyczyło poprzedniego postoju
+        __atomic_store_n(&st->board, BOARD_MAKE(0, 0), __ATOMIC_RELEASE);  // Pusty, drzwi otwarte
+        // Flagi czytamy pod mutexem: pasażer zapisuje się do poczekalni pod tym
+        // samym mutexem, więc albo go tu obudzimy, albo zobaczy zamknięcie sam
+        int closed = bus_closed(bus);
+        if (!closed) {
+            wake_waiting(st);  // Autobus pusty - obudź czekających, ilu się zmieści
+        }
         sem_unlock();
 
         // Kończymy TYLKO gdy shutdown lub station_blocked
-        if (sd || sb) {
-            gate_unlock(3);  // Zwolnij dworzec
+        if (closed) {
+            release_platform(st);  // Zwolnij stanowisko
             break;  // Zakończ pracę
         }
 
         // Loguj przybycie
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [KIEROWCA %d] Autobus na dworcu\n", b, getpid());
-        log_write(ln);
+        unsigned long long arrive_ns = ev_now_ns();
+        log_event((struct EvRecord){ .type = EV_DRIVER_ARRIVE, .arg = pl });
 
         // === FAZA 2: OCZEKIWANIE NA PASAŻERÓW ===
-        // Czekamy T sekund lub na sygnał od dyspozytora (SIGUSR1)
-        int waited = 0;  // Licznik oczekiwanych sekund
-        while (!force_flag && waited < wait_time) {
-            sleep(1);  // Czekaj 1 sekundę
-            waited++;
-
-            // Sprawdź czy system się nie wyłącza
-            sem_lock();
-            sd = bus->shutdown;
-            sb = bus->station_blocked;
-            sem_unlock();
-
-            if (sd || sb) break;  // Jeśli shutdown, przerwij czekanie
-        }
-
-        // Ponownie sprawdź shutdown po zakończeniu czekania
-        sem_lock();
-        sd = bus->shutdown;
-        sb = bus->station_blocked;
-        sem_unlock();
-
-        if (sd || sb) {
-            gate_unlock(3);  // Zwolnij dworzec
+        // Czas postoju wyznacza zasada odjazdu (--policy, domyślnie full:
+        // T sekund modelu albo krócej, gdy autobus pełny); wymuszony odjazd
+        // (SIGUSR1) i shutdown kończą postój od razu (patrz dwell)
+        dwell(pl, arrive_ns);
+
+        // Ponownie sprawdź shutdown po zakończeniu czekania (odczyt atomowy)
+        if (bus_closed(bus)) {
+            release_platform(st);  // Zwolnij stanowisko
             break;  // Zakończ pracę
         }
 
         force_flag = 0;  // Zresetuj flagę wymuszonego odjazdu
 
-        // === FAZA 3: PRZYGOTOWANIE DO ODJAZDU ===
-        // Blokujemy wejścia - pasażerowie nie mogą już wchodzić
-        gate_lock(1);  // Zablokuj bramkę bez roweru
-        gate_lock(2);  // Zablokuj bramkę z rowerem
+        // === FAZA 3: ZAMKNIĘCIE DRZWI ===
+        // Jedna operacja atomowa: ustawiamy flagę odjazdu i dostajemy końcowy
+        // stan autobusu. Każdy CAS pasażera wykonał się przed nią (jest policzony)
+        // albo nie powiedzie się (widzi BOARD_DEPARTING).
+        unsigned long long w = __atomic_fetch_or(&st->board, BOARD_DEPARTING, __ATOMIC_ACQ_REL);
+        __atomic_store_n(&bus->last_depart_ns, ev_now_ns(), __ATOMIC_RELEASE);  // Odstęp dla zasady headway
+        int p = BOARD_PASSENGERS(w);  // Liczba pasażerów
+        int r = BOARD_BIKES(w);  // Liczba rowerów
+
+        // Kontrola niezmiennika: CAS pasażera nigdy nie przekracza P ani R
+        if (p > bus->P || r > bus->R) {
+            fprintf(stderr, "KIEROWCA %d: przekroczony limit na stanowisku %d (%d/%d pasazerow, %d/%d rowerow)\n",
+                    getpid(), pl, p, bus->P, r, bus->R);
+        }
 
-        // Ustaw flagę departing i odczytaj liczbę pasażerów/rowerów
-        sem_lock();
-        bus->departing = 1;  // Autobus odjeżdża
-        int p = bus->passengers;  // Liczba pasażerów
-        int r = bus->bikes;  // Liczba rowerów
-        bus->boarded_passengers += p;  // Zwiększ całkowitą liczbę przewiezionych
-        sem_unlock();
+        __atomic_fetch_add(&bus->boarded_passengers, p, __ATOMIC_RELAXED);  // Zwiększ całkowitą liczbę przewiezionych
 
         // Loguj odjazd
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [KIEROWCA %d] Odjazd: %d pasazerow, %d rowerow\n", 
-                 b, getpid(), p, r);
-        log_write(ln);
-
-        // === FAZA 4: RESET LICZNIKÓW ===
-        // Reset liczników - autobus opuszcza dworzec pusty dla następnego cyklu
-        sem_lock();
-        bus->passengers = 0;  // Wyzeruj pasażerów
-        bus->bikes = 0;  // Wyzeruj rowery
-        sem_unlock();
+        log_event((struct EvRecord){ .type = EV_DRIVER_DEPART, .arg = pl, .passengers = p, .bikes = r });
+        stat_add(stats, ST_DEPARTURES, 1);
 
-        // Odblokowujemy wejścia i dworzec - teraz może przyjechać następny autobus
-        gate_unlock(1);  // Odblokuj bramkę bez roweru
-        gate_unlock(2);  // Odblokuj bramkę z rowerem
-        gate_unlock(3);  // Zwolnij dworzec dla następnego autobusu
+        // === FAZA 4: ZWOLNIENIE STANOWISKA ===
+        release_platform(st);  // Następny autobus może wjechać
 
         // === FAZA 5: PODRÓŻ ===
         // Jazda (losowy czas 3-9s) - symulacja przewożenia pasażerów
-        int Ti = (rand() % 7) + 3;  // Losowy czas z zakresu [3, 9]
-        sleep(Ti);  // Symuluj jazdę
+        int Ti = rng_below(&rng, 7) + 3;  // Losowy czas z zakresu [3, 9]
+        ts_sleep(Ti, bus->time_scale);  // Symuluj jazdę
 
         // Loguj powrót
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [KIEROWCA %d] Powrot po %ds\n", b, getpid(), Ti);
-        log_write(ln);
+        log_event((struct EvRecord){ .type = EV_DRIVER_RETURN, .arg = Ti });
 
         // === FAZA 6: SPRAWDZENIE SHUTDOWN PO POWROCIE ===
-        sem_lock();
-        sd = bus->shutdown;
-        sb = bus->station_blocked;
-        sem_unlock();
-
-        if (sd || sb) break;  // Jeśli shutdown, nie wracaj na dworzec
+        if (bus_closed(bus)) break;  // Jeśli shutdown, nie wracaj na dworzec
 
         // Jeśli nie ma shutdown, pętla się powtarza - autobus wraca na dworzec
     }
 
     // === ZAKOŃCZENIE PRACY ===
-    ts(b, sizeof(b));
-    snprintf(ln, sizeof(ln), "[%s] [KIEROWCA %d] Koniec pracy\n", b, getpid());
-    log_write(ln);
+    // Nikt już nie przyjedzie - budzimy poczekalnię, żeby pasażerowie zobaczyli shutdown
+    sem_lock();
+    wake_all();
+    sem_unlock();
+
+    log_event((struct EvRecord){ .type = EV_DRIVER_END });
 
     shmdt(bus);  // Odłącz pamięć dzieloną
     return 0;
@@ -0,0 +1,326 @@
+/*
+ * EVLOG.H - Binarny format zdarzeń systemu
+ *
+ * Każde zdarzenie (przybycie pasażera, odjazd autobusu, rejestracja w kasie...)
+ * jest zapisywane jako rekord stałej długości zamiast linii tekstu.
+ * Procesy nie formatują tekstu - robi to dopiero logger (tryb tekstowy)
+ * albo narzędzie busdump (konwersja pliku binarnego do report.txt).
+ *
+ * Plik binarny (report.bin) = nagłówek EvFileHeader + tablica EvRecord,
+ * dzięki czemu można go zmapować (mmap) i analizować bez parsowania.
+ */
+
+#ifndef EVLOG_H
+#define EVLOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define EV_REPORT_TXT "report.txt"  // Raport tekstowy (domyślny)
+#define EV_REPORT_BIN "report.bin"  // Raport binarny (opcja --binary-log)
+#define EV_MAGIC "BUSEVT1"          // Identyfikator pliku binarnego
+#define EV_VERSION 1                // Wersja formatu rekordu
+
+// === TYPY ZDARZEŃ ===
+// Wartości są częścią formatu pliku - nowe typy dopisujemy na końcu
+enum EvType {
+    EV_NONE = 0,
+    EV_MAIN_START,              // arg=N passengers=P bikes=R arg2=T
+    EV_MAIN_SHUTDOWN,
+    EV_MAIN_END,
+    EV_MAIN_LOG_DROPPED,        // arg=liczba utraconych wpisów
+    EV_DRIVER_START,
+    EV_DRIVER_ARRIVE,           // arg=stanowisko
+    EV_DRIVER_DEPART,           // arg=stanowisko, passengers, bikes
+    EV_DRIVER_RETURN,           // arg=Ti
+    EV_DRIVER_END,
+    EV_CASHIER_START,           // arg=okienko, passengers=liczba okienek
+    EV_CASHIER_REGISTER,        // arg=PID pasażera, arg2=okienko, passengers=liczba okienek, vip, child
+    EV_CASHIER_END,             // arg=okienko, passengers=liczba okienek
+    EV_DISPATCHER_START,
+    EV_DISPATCHER_FORCE,
+    EV_DISPATCHER_BLOCK,
+    EV_DISPATCHER_END,
+    EV_GENERATOR_START,
+    EV_GENERATOR_END,
+    EV_PASSENGER_ARRIVE,        // vip, age, bike, child
+    EV_PASSENGER_CLOSED,
+    EV_PASSENGER_CLOSED_REG,
+    EV_PASSENGER_NO_TICKET,
+    EV_PASSENGER_SYSTEM_CLOSED,
+    EV_PASSENGER_BOARD,         // vip, bike
+    EV_PASSENGER_CLOSED_WAIT,
+    EV_CHILD_REFUSED,
+    EV_FAMILY_BOARD,            // vip, bike
+    EV_MAIN_CASHIER_LOAD,       // arg=okienko, arg2=rejestracje, passengers=udział w promilach
+    EV_MAIN_SEED,               // arg=ziarno (--seed)
+    EV_PASSENGER_TICKET,        // arg=czas rejestracja→bilet (us); tylko przy --binary-log
+    EV_MAIN_RUSAGE,             // passengers=komponent (enum EvComponent), arg=CPU (ms), arg2=przełączenia kontekstu, bikes=procesy
+    EV_DISPATCHER_DWELL,        // arg=nowy postój (ms modelu), arg2=przybycia (EWMA, 1/1000 na s), passengers=poczekalnia (EWMA)
+    EV_MAIN_REG_ABANDONED,      // arg=pominięte porzucone sloty pierścienia rejestracji
+    EV_TYPE_COUNT
+};
+
+// === KOMPONENTY (zużycie zasobów w EV_MAIN_RUSAGE) ===
+enum EvComponent {
+    EV_COMP_MAIN = 0,
+    EV_COMP_LOGGER,
+    EV_COMP_DRIVERS,
+    EV_COMP_CASHIERS,
+    EV_COMP_DISPATCHER,
+    EV_COMP_PASSENGERS,         // Generator razem z pasażerami (jego potomkami)
+    EV_COMP_EXPORTER,           // Eksporter metryk (--metrics)
+    EV_COMP_COUNT
+};
+
+static const char* const ev_comp_names[EV_COMP_COUNT] = {
+    "main", "logger", "drivers", "cashiers", "dispatcher", "passengers", "exporter"
+};
+
+/*
+ * Struktura EvRecord - pojedyncze zdarzenie (32 bajty)
+ *
+ * ts_ns to czas monotoniczny (CLOCK_MONOTONIC) - różnice czasów są dokładne
+ * i nie zależą od zmian zegara systemowego. Czas ścienny do raportu
+ * odtwarzamy dodając clock_offset_ns z nagłówka pliku.
+ */
+struct EvRecord {
+    uint64_t ts_ns;             // Znacznik czasu (monotoniczny, ns)
+    int32_t pid;                // PID procesu, który zgłosił zdarzenie
+    int32_t arg;                // Argument zależny od typu (PID, Ti, N...)
+    int32_t arg2;               // Drugi argument (T dla EV_MAIN_START)
+    int16_t passengers;         // Liczba pasażerów (odjazd) / P
+    int16_t bikes;              // Liczba rowerów (odjazd) / R
+    uint16_t type;              // Typ zdarzenia (enum EvType)
+    uint8_t vip;                // 1 = pasażer VIP
+    uint8_t bike;               // 1 = pasażer z rowerem
+    uint8_t child;              // 1 = dziecko / pasażer z dzieckiem
+    uint8_t age;                // Wiek pasażera
+    uint8_t pad[2];
+};
+
+/*
+ * Struktura EvFileHeader - nagłówek pliku report.bin (64 bajty)
+ */
+struct EvFileHeader {
+    char magic[8];              // EV_MAGIC
+    uint32_t version;           // EV_VERSION
+    uint32_t record_size;       // sizeof(struct EvRecord)
+    int64_t clock_offset_ns;    // Czas ścienny - czas monotoniczny (ns)
+    char pad[40];
+};
+
+/*
+ * Funkcja ev_now_ns - aktualny czas monotoniczny w nanosekundach
+ */
+static inline uint64_t ev_now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+/*
+ * Funkcja ev_clock_offset - różnica między zegarem ściennym a monotonicznym
+ * (zapamiętywana raz przy starcie systemu)
+ */
+static inline int64_t ev_clock_offset(void) {
+    struct timespec w;
+    clock_gettime(CLOCK_REALTIME, &w);
+    int64_t wall = (int64_t)w.tv_sec * 1000000000LL + w.tv_nsec;
+    return wall - (int64_t)ev_now_ns();
+}
+
+/*
+ * Funkcja ev_clock - formatuje czas zdarzenia jako HH:MM:SS
+ * Parametry:
+ *   ts_ns - czas monotoniczny zdarzenia
+ *   offset - clock_offset_ns
+ *   buf - bufor wynikowy (min. 9 bajtów)
+ */
+static inline void ev_clock(uint64_t ts_ns, int64_t offset, char* buf, size_t n) {
+    time_t t = (time_t)(((int64_t)ts_ns + offset) / 1000000000LL);
+    struct tm tm_info;
+    if (localtime_r(&t, &tm_info) == NULL) {
+        snprintf(buf, n, "00:00:00");
+        return;
+    }
+    strftime(buf, n, "%H:%M:%S", &tm_info);
+}
+
+/*
+ * Funkcja ev_cashier_tag - nazwa modułu kasy w linii raportu
+ * Parametry:
+ *   windows - liczba okienek (pole passengers rekordu)
+ *   window - numer okienka
+ *
+ * Przy jednym okienku zostaje dotychczasowe "KASA"; numer okienka
+ * ("KASA 1") pojawia się tylko przy --cashiers > 1.
+ */
+static inline const char* ev_cashier_tag(char* buf, size_t n, int windows, int window) {
+    if (windows <= 1) return "KASA";
+    snprintf(buf, n, "KASA %d", window);
+    return buf;
+}
+
+/*
+ * Funkcja ev_format - zamienia rekord na linię report.txt
+ * Parametry:
+ *   e - rekord zdarzenia
+ *   clk - czas w formacie HH:MM:SS
+ *   buf, n - bufor wynikowy
+ *
+ * Zwraca długość linii (0 dla nieznanego typu).
+ * Treść linii jest identyczna z dotychczasowym formatem tekstowym.
+ */
+static inline int ev_format(const struct EvRecord* e, const char* clk, char* buf, size_t n) {
+    int r = 0;
+    char tag[16];
+    switch (e->type) {
+    case EV_MAIN_START:
+        r = snprintf(buf, n, "[%s] [MAIN] Start systemu: N=%d P=%d R=%d T=%d\n",
+                     clk, e->arg, e->passengers, e->bikes, e->arg2);
+        break;
+    case EV_MAIN_SHUTDOWN:
+        r = snprintf(buf, n, "[%s] [MAIN] Shutdown initiated\n", clk);
+        break;
+    case EV_MAIN_END:
+        r = snprintf(buf, n, "[%s] [MAIN] System zakonczony\n", clk);
+        break;
+    case EV_MAIN_LOG_DROPPED:
+        r = snprintf(buf, n, "[%s] [MAIN] Utracone wpisy logu: %d\n", clk, e->arg);
+        break;
+    case EV_DRIVER_START:
+        r = snprintf(buf, n, "[%s] [KIEROWCA %d] Start pracy\n", clk, e->pid);
+        break;
+    case EV_DRIVER_ARRIVE:
+        r = snprintf(buf, n, "[%s] [KIEROWCA %d] Autobus na dworcu\n", clk, e->pid);
+        break;
+    case EV_DRIVER_DEPART:
+        r = snprintf(buf, n, "[%s] [KIEROWCA %d] Odjazd: %d pasazerow, %d rowerow\n",
+                     clk, e->pid, e->passengers, e->bikes);
+        break;
+    case EV_DRIVER_RETURN:
+        r = snprintf(buf, n, "[%s] [KIEROWCA %d] Powrot po %ds\n", clk, e->pid, e->arg);
+        break;
+    case EV_DRIVER_END:
+        r = snprintf(buf, n, "[%s] [KIEROWCA %d] Koniec pracy\n", clk, e->pid);
+        break;
+    case EV_CASHIER_START:
+        r = snprintf(buf, n, "[%s] [%s] Start pracy\n", clk,
+                     ev_cashier_tag(tag, sizeof(tag), e->passengers, e->arg));
+        break;
+    case EV_CASHIER_REGISTER:
+        r = snprintf(buf, n, "[%s] [%s] Rejestracja PID=%d VIP=%d DZIECKO=%d\n",
+                     clk, ev_cashier_tag(tag, sizeof(tag), e->passengers, e->arg2), e->arg, e->vip, e->child);
+        break;
+    case EV_CASHIER_END:
+        r = snprintf(buf, n, "[%s] [%s] Koniec pracy\n", clk,
+                     ev_cashier_tag(tag, sizeof(tag), e->passengers, e->arg));
+        break;
+    case EV_DISPATCHER_START:
+        r = snprintf(buf, n, "[%s] [DYSPOZYTOR] Start pracy\n", clk);
+        break;
+    case EV_DISPATCHER_FORCE:
+        r = snprintf(buf, n, "[%s] [DYSPOZYTOR] Wymuszenie odjazdu\n", clk);
+        break;
+    case EV_DISPATCHER_BLOCK:
+        r = snprintf(buf, n, "[%s] [DYSPOZYTOR] Blokada dworca\n", clk);
+        break;
+    case EV_DISPATCHER_END:
+        r = snprintf(buf, n, "[%s] [DYSPOZYTOR] Koniec pracy\n", clk);
+        break;
+    case EV_GENERATOR_START:
+        r = snprintf(buf, n, "[%s] [GENERATOR] Start - tworzy pasazerow w nieskonczonosc\n", clk);
+        break;
+    case EV_GENERATOR_END:
+        r = snprintf(buf, n, "[%s] [GENERATOR] Koniec pracy\n", clk);
+        break;
+    case EV_PASSENGER_ARRIVE:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Przybycie (VIP=%d wiek=%d rower=%d dziecko=%d)\n",
+                     clk, e->pid, e->vip, e->age, e->bike, e->child);
+        break;
+    case EV_PASSENGER_CLOSED:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Dworzec zamkniety\n", clk, e->pid);
+        break;
+    case EV_PASSENGER_CLOSED_REG:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Dworzec zamkniety przed rejestracją\n", clk, e->pid);
+        break;
+    case EV_PASSENGER_NO_TICKET:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Brak biletu\n", clk, e->pid);
+        break;
+    case EV_PASSENGER_SYSTEM_CLOSED:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] System zamkniety\n", clk, e->pid);
+        break;
+    case EV_PASSENGER_BOARD:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Wsiadl (VIP=%d rower=%d)\n",
+                     clk, e->pid, e->vip, e->bike);
+        break;
+    case EV_PASSENGER_CLOSED_WAIT:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Dworzec zamkniety podczas oczekiwania\n", clk, e->pid);
+        break;
+    case EV_CHILD_REFUSED:
+        r = snprintf(buf, n, "[%s] [DZIECKO %d] Bez opiekuna - odmowa\n", clk, e->pid);
+        break;
+    case EV_FAMILY_BOARD:
+        r = snprintf(buf, n, "[%s] [DOROSLY+DZIECKO %d] Wsiadl (VIP=%d rower=%d)\n",
+                     clk, e->pid, e->vip, e->bike);
+        break;
+    case EV_MAIN_CASHIER_LOAD:
+        r = snprintf(buf, n, "[%s] [MAIN] Kasa %d: %d rejestracji (%d.%d%%)\n",
+                     clk, e->arg, e->arg2, e->passengers / 10, e->passengers % 10);
+        break;
+    case EV_PASSENGER_TICKET:
+        r = snprintf(buf, n, "[%s] [PASAZER %d] Bilet po %d us\n", clk, e->pid, e->arg);
+        break;
+    case EV_MAIN_RUSAGE:
+        r = snprintf(buf, n, "[%s] [MAIN] Zasoby %s (%d proc.): CPU %d ms, przelaczen kontekstu %d\n",
+                     clk, e->passengers >= 0 && e->passengers < EV_COMP_COUNT ? ev_comp_names[e->passengers] : "?",
+                     e->bikes, e->arg, e->arg2);
+        break;
+    case EV_MAIN_SEED:
+        r = snprintf(buf, n, "[%s] [MAIN] Ziarno losowe: %u\n", clk, (unsigned)e->arg);
+        break;
+    case EV_DISPATCHER_DWELL:
+        r = snprintf(buf, n, "[%s] [DYSPOZYTOR] Postoj T = %d.%d s (przybycia %d.%02d/s, poczekalnia %d)\n",
+                     clk, e->arg / 1000, e->arg % 1000 / 100, e->arg2 / 1000, e->arg2 % 1000 / 10, e->passengers);
+        break;
+    case EV_MAIN_REG_ABANDONED:
+        r = snprintf(buf, n, "[%s] [MAIN] Porzucone rejestracje w pierscieniu: %d\n", clk, e->arg);
+        break;
+    default:
+        return 0;
+    }
+    if (r < 0) return 0;
+    if ((size_t)r >= n) r = (int)n - 1;  // Linia obcięta do rozmiaru bufora
+    return r;
+}
+
+/*
+ * Funkcja ev_append - dopisuje pojedynczy rekord bezpośrednio do raportu
+ * (bez pośrednictwa loggera - używane gdy pierścień logów jest niedostępny)
+ * Parametry:
+ *   e - rekord zdarzenia
+ *   binary - 1 = report.bin, 0 = report.txt
+ *   offset - clock_offset_ns
+ */
+static inline void ev_append(const struct EvRecord* e, int binary, int64_t offset) {
+    int fd = open(binary ? EV_REPORT_BIN : EV_REPORT_TXT, O_CREAT | O_WRONLY | O_APPEND, 0600);
+    if (fd == -1) return;
+    if (binary) {
+        if (write(fd, e, sizeof(*e)) == -1) perror("write report");
+    }
+    else {
+        char clk[16];
+        char ln[256];
+        ev_clock(e->ts_ns, offset, clk, sizeof(clk));
+        int len = ev_format(e, clk, ln, sizeof(ln));
+        if (len > 0 && write(fd, ln, (size_t)len) == -1) perror("write report");
+    }
+    close(fd);
+}
+
+#endif
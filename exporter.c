@@ -0,0 +1,288 @@
+/*
+ * EXPORTER.C - Eksporter metryk w formacie tekstowym Prometheusa
+ *
+ * Proces uruchamiany przez main przy opcji --metrics ADRES. Nasłuchuje na
+ * gnieździe UNIX (ADRES = ścieżka) albo na porcie TCP 127.0.0.1 (ADRES =
+ * numer portu) i na każde połączenie odpowiada HTTP/1.0 z metrykami:
+ * - liczniki z segmentu statystyk (stats.h): przybycia, rejestracje,
+ *   bilety, wejścia, odjazdy, odmowy
+ * - wartości bieżące: długość kolejki komunikatów, poczekalnia,
+ *   active_passengers, pasażerowie i rowery w autobusie na każdym
+ *   stanowisku, blokada dworca i epoka słowa sterującego
+ *
+ * Obsługa zapytania to stała liczba odczytów atomowych i jedno
+ * msgctl(IPC_STAT) - bez semafora 0 (mutexu BusState), więc scrape nie
+ * spowalnia pasażerów ani kierowców.
+ *
+ * Przykład:
+ *   ./main 3 10 3 5 --metrics bus.sock
+ *   curl --unix-socket bus.sock http://localhost/metrics
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/msg.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "ipc.h"
+#include "stats.h"
+
+#define EXPORTER_POLL_MS 200    // Co tyle ms sprawdzamy shutdown, gdy nikt nie pyta
+#define EXPORTER_READ_MS 100    // Limit czekania na treść zapytania
+#define EXPORTER_BUF 16384      // Bufor odpowiedzi (metryki + nagłówek HTTP)
+
+// Globalne zmienne
+struct BusState* bus;  // Stan systemu (tylko odczyty atomowe)
+struct BusStats* stats;  // Segment statystyk (NULL = brak liczników)
+int msgid = -1;  // Kolejka komunikatów (długość kolejki)
+volatile sig_atomic_t should_exit = 0;  // Flaga zakończenia (SIGINT / SIGTERM)
+
+/*
+ * Handler SIGINT/SIGTERM - kończy pętlę (poll() zwraca EINTR)
+ */
+void handle_exit(int sig) {
+    (void)sig;
+    should_exit = 1;
+}
+
+/*
+ * Funkcja open_listener - tworzy gniazdo nasłuchujące
+ * Parametry:
+ *   addr - ścieżka gniazda UNIX albo numer portu TCP (127.0.0.1)
+ *
+ * Zwraca deskryptor albo -1.
+ */
+int open_listener(const char* addr) {
+    int is_port = addr[0] != '\0' && strspn(addr, "0123456789") == strlen(addr);
+    int fd;
+    if (is_port) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons((unsigned short)atoi(addr));
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Tylko lokalnie
+        if (bind(fd, (struct sockaddr*)&sin, sizeof(sin)) == -1) {
+            close(fd);
+            return -1;
+        }
+    }
+    else {
+        struct sockaddr_un sun;
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        if (strlen(addr) >= sizeof(sun.sun_path)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        strcpy(sun.sun_path, addr);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1) return -1;
+        unlink(addr);  // Pozostałość po poprzednim przebiegu
+        if (bind(fd, (struct sockaddr*)&sun, sizeof(sun)) == -1) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, 16) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Funkcja metric - dopisuje do bufora metrykę bez etykiet (z HELP i TYPE)
+ */
+int metric(char* buf, int len, const char* name, const char* type, const char* help, long value) {
+    if (len >= EXPORTER_BUF) return len;
+    len += snprintf(buf + len, EXPORTER_BUF - len, "# HELP %s %s\n# TYPE %s %s\n%s %ld\n",
+                    name, help, name, type, name, value);
+    return len;
+}
+
+/*
+ * Funkcja render - tekst metryk (format ekspozycji Prometheusa 0.0.4)
+ * Zwraca długość tekstu w buforze
+ */
+int render(char* buf) {
+    int len = 0;
+
+    // === LICZNIKI (segment statystyk) ===
+    if (stats) {
+        len = metric(buf, len, "bus_arrivals_total", "counter", "Passengers created by the generator.", stat_read(stats, ST_ARRIVALS));
+        len = metric(buf, len, "bus_registrations_total", "counter", "Registrations received by the cashier.", stat_read(stats, ST_REGISTRATIONS));
+        len = metric(buf, len, "bus_tickets_total", "counter", "Tickets issued by the cashier.", stat_read(stats, ST_TICKETS));
+        len = metric(buf, len, "bus_boardings_total", "counter", "People who boarded a bus, children included.", stat_read(stats, ST_BOARDINGS));
+        len = metric(buf, len, "bus_departures_total", "counter", "Bus departures.", stat_read(stats, ST_DEPARTURES));
+        if (len < EXPORTER_BUF) {
+            len += snprintf(buf + len, EXPORTER_BUF - len,
+                            "# HELP bus_refused_total Passengers turned away.\n# TYPE bus_refused_total counter\n"
+                            "bus_refused_total{reason=\"child\"} %ld\nbus_refused_total{reason=\"closed\"} %ld\n",
+                            stat_read(stats, ST_CHILD_REFUSED), stat_read(stats, ST_CLOSED_REFUSED));
+        }
+        long wait = stat_read(stats, ST_WAITING);
+        len = metric(buf, len, "bus_waiting_room_passengers", "gauge", "Passengers in the waiting rooms.", wait > 0 ? wait : 0);
+    }
+
+    // === KOLEJKA KOMUNIKATÓW ===
+    struct msqid_ds q;
+    if (msgid != -1 && msgctl(msgid, IPC_STAT, &q) == 0) {
+        len = metric(buf, len, "bus_queue_depth", "gauge", "Messages in the SysV registration queue (0 when --reg-ring is used).", (long)q.msg_qnum);
+    }
+
+    // === STAN SYSTEMU (odczyty atomowe z BusState) ===
+    len = metric(buf, len, "bus_active_passengers", "gauge", "Passengers currently in the system.",
+                 __atomic_load_n(&bus->active_passengers, __ATOMIC_RELAXED));
+    unsigned long long ctrl = bus_control(bus);  // Flagi i epoka z jednego odczytu
+    len = metric(buf, len, "bus_station_blocked", "gauge", "1 if the station is closed to new passengers.",
+                 (ctrl & CTRL_BLOCKED) != 0);
+    len = metric(buf, len, "bus_control_epoch", "counter", "Changes of the shutdown/station-blocked control word.",
+                 CTRL_EPOCH(ctrl));
+    len = metric(buf, len, "bus_capacity_passengers", "gauge", "Bus passenger capacity P.", bus->P);
+    len = metric(buf, len, "bus_capacity_bikes", "gauge", "Bus bike capacity R.", bus->R);
+    len = metric(buf, len, "bus_dwell_milliseconds", "gauge", "Current dwell time T in model milliseconds (--adaptive-dwell).",
+                 __atomic_load_n(&bus->dwell_ms, __ATOMIC_RELAXED));
+
+    // Słowo wsiadania stanowiska: BOARD_DEPARTING = brak autobusu z otwartymi drzwiami
+    if (len < EXPORTER_BUF) {
+        len += snprintf(buf + len, EXPORTER_BUF - len,
+                        "# HELP bus_passengers Passengers on the bus at the platform.\n# TYPE bus_passengers gauge\n");
+    }
+    unsigned long long board[MAX_PLATFORMS];
+    for (int i = 0; i < bus->platforms; i++) {
+        board[i] = __atomic_load_n(&bus->platform[i].board, __ATOMIC_ACQUIRE);
+        if (board[i] & BOARD_DEPARTING) board[i] = 0;
+        if (len < EXPORTER_BUF) {
+            len += snprintf(buf + len, EXPORTER_BUF - len, "bus_passengers{platform=\"%d\"} %d\n", i, (int)BOARD_PASSENGERS(board[i]));
+        }
+    }
+    if (len < EXPORTER_BUF) {
+        len += snprintf(buf + len, EXPORTER_BUF - len,
+                        "# HELP bus_bikes Bikes on the bus at the platform.\n# TYPE bus_bikes gauge\n");
+    }
+    for (int i = 0; i < bus->platforms; i++) {
+        if (len < EXPORTER_BUF) {
+            len += snprintf(buf + len, EXPORTER_BUF - len, "bus_bikes{platform=\"%d\"} %d\n", i, (int)BOARD_BIKES(board[i]));
+        }
+    }
+    return len < EXPORTER_BUF ? len : EXPORTER_BUF - 1;
+}
+
+/*
+ * Funkcja serve - obsługa jednego połączenia
+ * Treść zapytania nie ma znaczenia (każda ścieżka zwraca metryki);
+ * czytamy ją tylko po to, żeby klient nie dostał RST przed odpowiedzią
+ */
+void serve(int fd) {
+    char req[1024];
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, EXPORTER_READ_MS) > 0) {
+        if (read(fd, req, sizeof(req)) < 0) {
+            return;
+        }
+    }
+
+    static char body[EXPORTER_BUF];
+    static char out[EXPORTER_BUF + 256];
+    int blen = render(body);
+    int len = snprintf(out, sizeof(out),
+                       "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                       "Content-Length: %d\r\nConnection: close\r\n\r\n%.*s", blen, blen, body);
+    for (int off = 0; off < len;) {
+        ssize_t w = write(fd, out + off, (size_t)(len - off));
+        if (w <= 0) {
+            if (w == -1 && errno == EINTR) continue;
+            break;  // Klient się rozłączył
+        }
+        off += (int)w;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Uzycie: %s SCIEZKA_GNIAZDA|PORT\n", argv[0]);
+        return 1;
+    }
+    const char* addr = argv[1];
+
+    // === PODŁĄCZENIE DO ZASOBÓW IPC ===
+    key_t shm_key = ftok(SHM_PATH, 'S');
+    if (shm_key == -1) {
+        perror("ftok shm");
+        return 1;
+    }
+    int shmid = shmget(shm_key, 0, 0600);  // Rozmiar 0 - układ sprawdzamy po wersji, nie po rozmiarze
+    if (shmid == -1) {
+        perror("shmget");
+        return 1;
+    }
+    bus = shmat(shmid, NULL, SHM_RDONLY);  // Eksporter tylko czyta stan
+    if (bus == (void*)-1) {
+        perror("shmat");
+        return 1;
+    }
+    if (!bus_layout_ok(bus)) {
+        fprintf(stderr, "exporter: niezgodny uklad BusState (wersja %u, oczekiwana %d) - przebuduj program\n",
+                bus->layout_version, BUS_LAYOUT_VERSION);
+        return 1;
+    }
+    stats = stats_attach();  // Brak segmentu - tylko metryki z BusState
+    key_t msg_key = ftok(MSG_PATH, 'M');
+    if (msg_key != -1) {
+        msgid = msgget(msg_key, 0600);
+    }
+
+    // === SYGNAŁY ===
+    // SIGINT/SIGTERM bez SA_RESTART - przerywają poll(); SIGPIPE ignorujemy
+    // (klient rozłączony w trakcie odpowiedzi to nie błąd eksportera)
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_exit;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    // === GNIAZDO NASŁUCHUJĄCE ===
+    int lfd = open_listener(addr);
+    if (lfd == -1) {
+        perror("exporter listen");
+        shmdt(bus);
+        return 1;
+    }
+
+    // === PĘTLA OBSŁUGI ZAPYTAŃ ===
+    // poll() z limitem czasu - bez zapytań i tak co chwilę sprawdzamy shutdown
+    while (!should_exit && !bus_shutting_down(bus)) {
+        struct pollfd pfd = { lfd, POLLIN, 0 };
+        int r = poll(&pfd, 1, EXPORTER_POLL_MS);
+        if (r <= 0) continue;  // Limit czasu albo EINTR
+        int cfd = accept(lfd, NULL, NULL);
+        if (cfd == -1) continue;
+        serve(cfd);
+        close(cfd);
+    }
+
+    // === ZAKOŃCZENIE PRACY ===
+    close(lfd);
+    if (strspn(addr, "0123456789") != strlen(addr)) {
+        unlink(addr);  // Usuń plik gniazda UNIX
+    }
+    if (stats) shmdt(stats);
+    shmdt(bus);
+    return 0;
+}
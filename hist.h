@@ -0,0 +1,107 @@
+/*
+ * HIST.H - Histogramy opóźnień pasażerów w pamięci dzielonej
+ *
+ * Dla każdego etapu drogi pasażera i każdej klasy pasażera (VIP / rower /
+ * z dzieckiem) trzymamy histogram z przedziałami logarytmicznymi: każda
+ * potęga dwójki nanosekund dzielona jest na HIST_SUB przedziałów, więc błąd
+ * odczytanego percentyla nie przekracza 1/HIST_SUB (25%) wartości.
+ *
+ * Zapis to jedna atomowa inkrementacja licznika (bez mutexu) - wołana przez
+ * pasażerów i kasę. Odczyt (percentyle) robi main po zakończeniu procesów.
+ */
+
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+
+// === ETAPY ===
+enum HistStage {
+    HIST_ARRIVE_REG = 0,        // Przybycie → rejestracja w kasie (kasa)
+    HIST_REG_TICKET,            // Rejestracja → bilet u pasażera (pasażer, bez VIP)
+    HIST_TICKET_BOARD,          // Bilet → wejście do autobusu (pasażer)
+    HIST_TOTAL,                 // Przybycie → wejście do autobusu (pasażer)
+    HIST_STAGES
+};
+
+static const char* const hist_stage_names[HIST_STAGES] = {
+    "przybycie->rejestracja", "rejestracja->bilet", "bilet->wejscie", "calkowity"
+};
+
+// === KLASY PASAŻERÓW ===
+// Indeks klasy = vip | rower << 1 | z_dzieckiem << 2
+#define HIST_CLASSES 8
+
+// === PRZEDZIAŁY ===
+#define HIST_SUB_BITS 2                         // 4 przedziały na potęgę dwójki
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_MAX_EXP 43                         // Górna granica: 2^44 ns (~4.9 h)
+#define HIST_BUCKETS ((HIST_MAX_EXP - HIST_SUB_BITS + 2) * HIST_SUB)
+
+/*
+ * Struktura LatHist - wszystkie histogramy (etap x klasa x przedział)
+ */
+struct LatHist {
+    unsigned long count[HIST_STAGES][HIST_CLASSES][HIST_BUCKETS];
+};
+
+/*
+ * Funkcja hist_class - indeks klasy pasażera
+ */
+static inline int hist_class(int vip, int bike, int family) {
+    return (vip ? 1 : 0) | (bike ? 2 : 0) | (family ? 4 : 0);
+}
+
+/*
+ * Funkcja hist_bucket - numer przedziału dla opóźnienia ns
+ * Wartości < HIST_SUB mają własne przedziały, dalej: wykładnik i
+ * HIST_SUB_BITS bitów za najstarszym bitem
+ */
+static inline int hist_bucket(uint64_t ns) {
+    if (ns < HIST_SUB) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    if (e > HIST_MAX_EXP) return HIST_BUCKETS - 1;
+    int sub = (int)((ns >> (e - HIST_SUB_BITS)) & (HIST_SUB - 1));
+    return (e - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+/*
+ * Funkcja hist_upper - górna granica przedziału b (ns)
+ */
+static inline uint64_t hist_upper(int b) {
+    if (b < HIST_SUB) return (uint64_t)b;
+    int e = b / HIST_SUB + HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b % HIST_SUB);
+    uint64_t width = 1ULL << (e - HIST_SUB_BITS);
+    return ((HIST_SUB + sub) << (e - HIST_SUB_BITS)) + width - 1;
+}
+
+/*
+ * Funkcja hist_add - dolicza jedno opóźnienie (atomowo, bez blokad)
+ */
+static inline void hist_add(struct LatHist* h, int stage, int cls, uint64_t ns) {
+    __atomic_fetch_add(&h->count[stage][cls][hist_bucket(ns)], 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Funkcja hist_percentile - percentyl z histogramu
+ * Parametry:
+ *   c - liczniki przedziałów (HIST_BUCKETS)
+ *   total - suma liczników
+ *   permille - percentyl w promilach (500 = p50, 999 = p99.9)
+ *
+ * Zwraca górną granicę przedziału zawierającego percentyl (ns).
+ */
+static inline uint64_t hist_percentile(const unsigned long* c, unsigned long total, int permille) {
+    if (total == 0) return 0;
+    unsigned long rank = (total * (unsigned long)permille + 999) / 1000;  // Zaokrąglenie w górę
+    if (rank == 0) rank = 1;
+    unsigned long seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += c[b];
+        if (seen >= rank) return hist_upper(b);
+    }
+    return hist_upper(HIST_BUCKETS - 1);
+}
+
+#endif
@@ -12,6 +12,8 @@
 #define IPC_H
 
 #include <sys/types.h>
+#include <pthread.h>
+#include "hist.h"
 
 // === ŚCIEŻKI DO PLIKÓW KLUCZY IPC ===
 // Te pliki są używane przez ftok() do generowania kluczy IPC
@@ -20,56 +22,212 @@
 #define SEM_PATH "bus_sem.key"  // Plik klucza dla semaforów
 #define MSG_PATH "bus_msg.key"  // Plik klucza dla kolejki komunikatów
 
+// === SEMAFORY ===
+// [0] mutex (buslock.h),
+// [1] dworzec - semafor zliczający = liczba stanowisk (ilu kierowców naraz),
+// [2]/[3] poczekalnie (bez roweru / z rowerem) - semafory zliczające bez SEM_UNDO
+// [4..] dzwonki stanowisk - budzą kierowcę czekającego na stanowisku, gdy autobus
+//       się zapełnił albo system się wyłącza (bez SEM_UNDO, zerowane przy przyjeździe)
+#define SEM_COUNT (SEM_DWELL + MAX_PLATFORMS)  // Liczba semaforów w zestawie
+#define SEM_STATION 1           // Dworzec - wolne stanowiska (kierowca: P przed wjazdem, V po odjeździe)
+#define SEM_ROOM 2              // Poczekalnia pasażerów bez roweru
+#define SEM_ROOM_BIKE 3         // Poczekalnia pasażerów z rowerem
+#define SEM_DWELL 4             // Dzwonek stanowiska 0 (stanowisko i: SEM_DWELL + i)
+
+// === SŁOWO WSIADANIA (BusState.board) ===
+// Liczba pasażerów, rowerów i flaga odjazdu w jednym 64-bitowym słowie,
+// zmienianym wyłącznie operacjami atomowymi (__atomic_*):
+//   bity 0-31  - pasażerowie w autobusie
+//   bity 32-62 - rowery w autobusie
+//   bit 63     - autobus odjeżdża (drzwi zamknięte)
+// Wejście pasażera to jeden CAS sprawdzający naraz P, R i flagę odjazdu.
+#define BOARD_DEPARTING (1ULL << 63)
+#define BOARD_MAKE(p, b) ((unsigned long long)(p) | ((unsigned long long)(b) << 32))
+#define BOARD_PASSENGERS(w) ((int)((w) & 0xFFFFFFFFULL))
+#define BOARD_BIKES(w) ((int)(((w) >> 32) & 0x7FFFFFFFULL))
+
+// === UKŁAD PAMIĘCI DZIELONEJ ===
+#define CACHE_LINE 64           // Rozmiar linii cache (x86-64) - granica regionów BusState
+#define BUS_LAYOUT_VERSION 3    // Wersja układu BusState - zwiększana przy każdej zmianie pól
+
+// === SŁOWO STERUJĄCE (BusState.control) ===
+// Stan systemu w jednym 64-bitowym słowie, czytanym jednym odczytem atomowym
+// (bez semafora i bez wywołania systemowego):
+//   bit 0      - system się wyłącza (shutdown)
+//   bit 1      - dworzec zablokowany (nowi pasażerowie nie mogą przyjść)
+//   bity 32-63 - epoka: rośnie przy każdej zmianie flag
+// Flagi są tylko ustawiane (bus_control_set), nigdy kasowane w trakcie pracy.
+#define CTRL_SHUTDOWN 1ULL
+#define CTRL_BLOCKED 2ULL
+#define CTRL_CLOSED (CTRL_SHUTDOWN | CTRL_BLOCKED)  // Dworzec nie przyjmuje pasażerów
+#define CTRL_EPOCH_ONE (1ULL << 32)
+#define CTRL_EPOCH(w) ((unsigned int)((w) >> 32))
+
+// === STANOWISKA ===
+#define MAX_PLATFORMS 8         // Maksymalna liczba stanowisk na dworcu (opcja --platforms K)
+
+/*
+ * Struktura Platform - jedno stanowisko na dworcu
+ *
+ * Każde stanowisko ma własne słowo wsiadania (drzwi autobusu) i własnego
+ * kierowcę - K autobusów może przyjmować pasażerów jednocześnie.
+ * Stanowisko zajmuje pełną linię cache: CAS wsiadania na jednym stanowisku
+ * nie unieważnia linii sąsiednich.
+ */
+struct Platform {
+    unsigned long long board;   // Słowo wsiadania: pasażerowie, rowery, flaga odjazdu (BOARD_*)
+                                // Tylko operacje atomowe - NIE jest chronione mutexem
+    pid_t driver_pid;           // PID kierowcy na stanowisku (0 = stanowisko wolne)
+} __attribute__((aligned(CACHE_LINE)));
+
 // === TYPY KOMUNIKATÓW ===
 // Komunikaty w kolejce używają pola 'type' do identyfikacji
 #define MSG_REGISTER 1          // Typ: rejestracja pasażera w kasie
-#define MSG_TICKET_REPLY 2      // Bazowy typ dla odpowiedzi z biletem
-                                // Rzeczywisty typ to MSG_TICKET_REPLY + PID pasażera
-                                // Dzięki temu każdy pasażer odbiera tylko swój bilet
+                                // (bilet wraca przez slot odpowiedzi w pamięci dzielonej, regring.h)
+#define MSG_WAKEUP_PID 0        // Rejestracja z pid = 0 to pobudka kasjera (np. przy shutdown),
+                                // a nie zgłoszenie pasażera
+
+// === OKIENKA KASY ===
+#define MAX_CASHIERS 16         // Maksymalna liczba okienek kasy (opcja --cashiers C)
+
+/*
+ * Struktura CashierWindow - liczniki jednego okienka kasy
+ *
+ * Każde okienko zapisuje tylko własne liczniki. Struktura zajmuje pełną
+ * linię cache (64 bajty), żeby okienka nie unieważniały sobie jej nawzajem.
+ */
+struct CashierWindow {
+    long registrations;         // Obsłużone rejestracje
+    long tickets;               // Wydane bilety
+    char pad[48];
+} __attribute__((aligned(CACHE_LINE)));
 
 /*
  * Struktura BusState - Stan Systemu Autobusowego
  * 
  * Ta struktura jest przechowywana w pamięci dzielonej i zawiera
  * wszystkie informacje o stanie systemu dostępne dla wszystkich procesów.
- * Dostęp do tej struktury jest chroniony semaforem mutex (sem[0]).
+ * Semafor mutex (sem[0]) chroni tylko złożone zmiany stanu wsiadania
+ * (zajęcie stanowiska, poczekalnia); flagi i pojedyncze liczniki są
+ * zmieniane i czytane atomowo.
+ *
+ * Pola są pogrupowane w regiony zaczynające się od nowej linii cache,
+ * według tego, kto je zapisuje i jak często:
+ * - konfiguracja - zapisuje tylko main przed startem procesów, potem
+ *   wyłącznie odczyt (linie współdzielone przez wszystkie rdzenie),
+ * - flagi sterujące - czytane ciągle przez wszystkich, zapisywane rzadko
+ *   (słowo sterujące, postój dyspozytora),
+ * - stanowiska - słowa wsiadania (CAS przy każdym wejściu), każde osobno,
+ * - liczniki pod mutexem - zapisywane przy każdym pasażerze, razem z mutexem,
+ * - statystyki - okienka kasy (każde we własnej linii) i histogramy.
+ * Zapis licznika pasażerów nie unieważnia więc linii, którą odpytują
+ * wszystkie procesy, ani konfiguracji.
  */
 struct BusState {
+    // === WERSJA UKŁADU ===
+    // Zawsze pierwsze pole (offset 0) - narzędzia sprawdzają ją przed
+    // odczytem reszty struktury (bus_layout_ok)
+    unsigned int layout_version;  // BUS_LAYOUT_VERSION programu main
+
     // === PARAMETRY KONFIGURACYJNE (stałe podczas działania) ===
     int P;                      // Maksymalna liczba pasażerów w autobusie
     int R;                      // Maksymalna liczba rowerów w autobusie
     int T;                      // Czas oczekiwania autobusu na dworcu (w sekundach)
     int N;                      // Liczba autobusów w systemie
-    
-    // === STAN AKTUALNEGO AUTOBUSU NA DWORCU ===
-    int passengers;             // Aktualna liczba pasażerów w autobusie na dworcu
-    int bikes;                  // Aktualna liczba rowerów w autobusie na dworcu
-    int departing;              // Flaga: 1 = autobus odjeżdża (pasażerowie nie mogą już wsiadać)
-    
-    // === STAN SYSTEMU ===
-    int station_blocked;        // Flaga: 1 = dworzec zablokowany (nowi pasażerowie nie mogą przyjść)
-    int active_passengers;      // Liczba aktywnych procesów pasażerów w systemie
-    int boarded_passengers;     // Całkowita liczba pasażerów, którzy wsiedli do autobusów
-    
-    // === KOMUNIKACJA Z KIEROWCĄ ===
-    pid_t driver_pid;           // PID kierowcy aktualnie stojącego na dworcu
-                                // Używane przez dyspozytora do wysyłania sygnałów
-    
-    // === FLAGA WYŁĄCZANIA ===
-    int shutdown;               // Flaga: 1 = system się wyłącza (wszystkie procesy kończą pracę)
+    int log_binary;             // 1 = raport w formacie binarnym (report.bin), 0 = report.txt
+    long long clock_offset_ns;  // Czas ścienny - monotoniczny (do odtwarzania HH:MM:SS w raporcie)
+    int pool_size;              // Liczba procesów w puli pasażerów (0 = osobny proces na pasażera)
+    int platforms;              // Liczba stanowisk na dworcu (1..MAX_PLATFORMS)
+    int cashiers;               // Liczba okienek kasy (1..MAX_CASHIERS)
+    double time_scale;          // Przyspieszenie czasu (--time-scale X, 1 = czas rzeczywisty)
+    unsigned int seed;          // Ziarno strumieni losowych (--seed S, rng.h)
+    double arrival_rate;        // Mnożnik częstości przybyć pasażerów (--arrival-rate X)
+    int policy;                 // Zasada odjazdu (--policy, policy.h)
+    double policy_arg;          // Parametr zasady (0 = domyślny)
+    double dwell_min, dwell_max;  // Granice zmiennego postoju (--adaptive-dwell, s modelu; 0 = stały T)
+    int reg_ring;               // 1 = rejestracje przez pierścień w pamięci dzielonej (--reg-ring, regring.h)
+
+    // === FLAGI STERUJĄCE (czytane ciągle, zapisywane rzadko) ===
+    unsigned long long control __attribute__((aligned(CACHE_LINE)));  // Słowo sterujące: CTRL_SHUTDOWN | CTRL_BLOCKED | epoka
+    int dwell_ms;               // Bieżący postój T (ms modelu) - zmienia go dyspozytor przy --adaptive-dwell
+
+    // === STAN AUTOBUSÓW NA DWORCU ===
+    struct Platform platform[MAX_PLATFORMS];  // Stanowiska (używane pierwsze 'platforms'), każde we własnej linii
+
+    // === LICZNIKI (zapisywane przy każdym pasażerze) ===
+    int active_passengers __attribute__((aligned(CACHE_LINE)));  // Liczba aktywnych pasażerów w systemie (atomowo)
+    int boarded_passengers;     // Całkowita liczba pasażerów, którzy wsiedli do autobusów (atomowo)
+    // Poczekalnia: pasażerowie, dla których zabrakło miejsca, czekają na semaforze poczekalni.
+    // Kierowca po przyjeździe budzi tylu, ilu zmieści się w autobusie.
+    int waiting;                // Liczba pasażerów bez roweru w poczekalni (nieobudzonych)
+    int waiting_bikes;          // Liczba pasażerów z rowerem w poczekalni (nieobudzonych)
+    unsigned long long last_depart_ns;  // Czas ostatniego odjazdu z dworca (ev_now_ns, 0 = brak; zasada headway)
+    // Mutex w tej samej linii co chronione liczniki - jedno przejęcie linii na sekcję krytyczną
+    pthread_mutex_t lock;       // Tylko make LOCK=futex (buslock.h); w trybie semaforów mutexem jest semafor 0
+
+    // === LICZNIKI OKIENEK KASY ===
+    struct CashierWindow window[MAX_CASHIERS];  // Używane pierwsze 'cashiers', każde we własnej linii
+
+    // === HISTOGRAMY OPÓŹNIEŃ (hist.h) ===
+    struct LatHist hist __attribute__((aligned(CACHE_LINE)));  // Etap x klasa pasażera, atomowe inkrementacje
 };
 
+/*
+ * Funkcja bus_layout_ok - sprawdza zgodność układu BusState z programem
+ * Zwraca 1 gdy segment utworzył main z tym samym układem pól.
+ */
+static inline int bus_layout_ok(const struct BusState* b) {
+    return __atomic_load_n(&b->layout_version, __ATOMIC_ACQUIRE) == BUS_LAYOUT_VERSION;
+}
+
+/*
+ * Funkcja bus_control - odczyt słowa sterującego (CTRL_*)
+ * Jeden odczyt atomowy - bez semafora, bezpieczny w pętlach odpytywania.
+ */
+static inline unsigned long long bus_control(const struct BusState* b) {
+    return __atomic_load_n(&b->control, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Funkcja bus_closed - czy dworzec jest zamknięty (shutdown albo blokada)
+ */
+static inline int bus_closed(const struct BusState* b) {
+    return (bus_control(b) & CTRL_CLOSED) != 0;
+}
+
+/*
+ * Funkcja bus_shutting_down - czy system się wyłącza
+ */
+static inline int bus_shutting_down(const struct BusState* b) {
+    return (bus_control(b) & CTRL_SHUTDOWN) != 0;
+}
+
+/*
+ * Funkcja bus_control_set - ustawia flagi w słowie sterującym
+ * Parametry:
+ *   flags - CTRL_SHUTDOWN i/lub CTRL_BLOCKED
+ *
+ * CAS ustawia flagi i podnosi epokę jedną operacją; gdy flagi już są
+ * ustawione, słowo się nie zmienia. Bez blokady - można wołać z handlera
+ * sygnału.
+ */
+static inline void bus_control_set(struct BusState* b, unsigned long long flags) {
+    unsigned long long w = __atomic_load_n(&b->control, __ATOMIC_RELAXED);
+    while ((w & flags) != flags &&
+           !__atomic_compare_exchange_n(&b->control, &w, (w | flags) + CTRL_EPOCH_ONE, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+}
+
 /*
  * Struktura msg - Komunikat w Kolejce Komunikatów
  * 
- * Używana do komunikacji między pasażerami a kasjerem:
- * 1. Pasażer -> Kasjer: rejestracja (type = MSG_REGISTER)
- * 2. Kasjer -> Pasażer: bilet (type = MSG_TICKET_REPLY + PID pasażera)
+ * Rejestracja pasażera w kasie (type = MSG_REGISTER). Przy --reg-ring ta
+ * sama struktura jest pozycją pierścienia rejestracji (regring.h).
+ * Bilet wraca przez slot odpowiedzi 'reply' (regring.h), nie przez kolejkę.
  */
 struct msg {
-    long type;          // Typ komunikatu (wymagane przez msgrcv/msgsnd)
-                        // Dla rejestracji: MSG_REGISTER
-                        // Dla biletu: MSG_TICKET_REPLY + PID
+    long type;          // Typ komunikatu (wymagane przez msgrcv/msgsnd): MSG_REGISTER
     
     // === INFORMACJE O PASAŻERZE ===
     pid_t pid;          // PID procesu pasażera
@@ -77,8 +235,27 @@ struct msg {
     int bike;           // 1 = pasażer ma rower
     int child;          // 1 = to dziecko (idzie z rodzicem)
     
-    // === INFORMACJA O BILECIE ===
-    int ticket_ok;      // 1 = bilet OK (używane w odpowiedzi od kasjera)
+    // === ADRES ODPOWIEDZI (BILET) ===
+    int reply;          // Slot odpowiedzi (-1 = VIP, nie czeka na bilet)
+    unsigned int reply_gen;  // Generacja rezerwacji slotu (spóźniona odpowiedź jest odrzucana)
+
+    // === ZNACZNIKI CZASU (histogramy opóźnień, CLOCK_MONOTONIC ns) ===
+    int family;                 // 1 = rodzic z dzieckiem (klasa histogramu)
+    unsigned long long arrive_ns;   // Przybycie pasażera (wypełnia pasażer)
+    unsigned long long reg_ns;      // Rejestracja w kasie (wypełnia kasa w odpowiedzi)
+};
+
+/*
+ * Struktura Arrival - przybycie pasażera w trybie puli
+ *
+ * Generator zapisuje ją do potoku, z którego czytają procesy puli.
+ * Zapis do potoku mniejszy niż PIPE_BUF jest atomowy, więc każdy
+ * rekord trafia w całości do dokładnie jednego procesu.
+ */
+struct Arrival {
+    int id;             // Numer pasażera nadany przez generator
+    unsigned long long arrive_ns;  // Chwila przybycia (ev_now_ns generatora) - czas
+                                   // oczekiwania w potoku liczy się do opóźnień pasażera
 };
 
 #endif
@@ -0,0 +1,225 @@
+/*
+ * LOGGER.C - Proces Zapisu Logów
+ *
+ * Ten proces opróżnia pierścień logów (logring.h) i zapisuje wpisy
+ * do pliku report.txt (lub report.bin w trybie binarnym).
+ * Główne zadania:
+ * - Zbieranie wielu wpisów z pierścienia do jednego bufora
+ * - Formatowanie rekordów zdarzeń do tekstu (tylko w trybie tekstowym)
+ * - Zapis bufora jednym wywołaniem write() (plik otwarty raz na cały czas pracy)
+ * - Pomijanie slotów porzuconych przez procesy zakończone w trakcie zapisu
+ * - Zakończenie pracy gdy system się wyłącza i nikt poza main nie pisze już logów
+ *
+ * Producenci (wszystkie pozostałe procesy) nigdy nie czekają na dysk -
+ * jedynym procesem wykonującym zapis do pliku jest logger.
+ */
+
+#define _DEFAULT_SOURCE  // syscall() - futex pierścienia logów (logring.h)
+
+#include <stdio.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "ipc.h"
+#include "logring.h"
+
+#define LOG_BATCH_BYTES 65536       // Rozmiar bufora jednego zapisu
+#define LOG_RECORD_MAX 256          // Maksymalny rozmiar jednego wpisu po sformatowaniu
+#define LOG_IDLE_SEC 0.1            // Najdłuższy sen przy pustym pierścieniu (sprawdzenie shutdown i niegotowych slotów)
+
+// Globalne zmienne
+int shmid, logid;  // ID segmentów pamięci dzielonej
+struct BusState* bus;  // Wskaźnik do stanu systemu
+struct LogRing* ring;  // Wskaźnik do pierścienia logów
+
+/*
+ * Funkcja append_record - dopisuje rekord do bufora zapisu
+ * Parametry:
+ *   e - rekord zdarzenia
+ *   out - miejsce w buforze (co najmniej LOG_RECORD_MAX bajtów)
+ *
+ * Zwraca liczbę zapisanych bajtów.
+ * W trybie tekstowym znacznik HH:MM:SS liczymy raz na sekundę.
+ */
+size_t append_record(const struct EvRecord* e, char* out) {
+    static long long last_sec = -1;
+    static char clk[16];
+
+    if (bus->log_binary) {
+        memcpy(out, e, sizeof(*e));
+        return sizeof(*e);
+    }
+
+    long long sec = ((long long)e->ts_ns + bus->clock_offset_ns) / 1000000000LL;
+    if (sec != last_sec) {
+        ev_clock(e->ts_ns, bus->clock_offset_ns, clk, sizeof(clk));
+        last_sec = sec;
+    }
+    return (size_t)ev_format(e, clk, out, LOG_RECORD_MAX);
+}
+
+/*
+ * Funkcja write_all - zapisuje cały bufor (write może zapisać mniej niż żądano)
+ */
+void write_all(int fd, const char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, buf, n);
+        if (w == -1) {
+            if (errno == EINTR) continue;
+            perror("write report");
+            return;
+        }
+        buf += w;
+        n -= (size_t)w;
+    }
+}
+
+/*
+ * Funkcja drain - przenosi gotowe wpisy z pierścienia do pliku
+ * Parametry:
+ *   fd - deskryptor pliku report.txt
+ *   stall_since - czas od którego slot na pozycji head nie jest gotowy (0 = brak)
+ *
+ * Zwraca liczbę przeniesionych wpisów.
+ */
+int drain(int fd, long long* stall_since) {
+    static char batch[LOG_BATCH_BYTES];
+    size_t used = 0;
+    int count = 0;
+    unsigned long pos = ring->head;
+
+    for (;;) {
+        struct LogSlot* slot = &ring->slots[pos & (LOG_RING_SLOTS - 1)];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+        if (seq != pos + 1) {
+            // Slot niegotowy: wolny (koniec wpisów), zarezerwowany przez
+            // producenta, który jeszcze go nie zajął, albo zajęty (zapis trwa).
+            // Po RING_STALL_SEC pomijamy rezerwację (producent weźmie następną
+            // pozycję) albo zajęty slot procesu, który już nie żyje.
+            if (seq == pos && __atomic_load_n(&ring->tail, __ATOMIC_RELAXED) <= pos) break;
+            long long now = (long long)ev_now_ns();
+            if (*stall_since == 0) {
+                *stall_since = now;
+                break;
+            }
+            if (now - *stall_since <= ring_stall_ns(bus->time_scale)) break;
+            if ((seq & RING_SEQ_CLAIMED) && !ring_owner_dead(seq)) {
+                *stall_since = now;  // Producent żyje - dokończy zapis
+                break;
+            }
+            unsigned long expected = seq;
+            if (__atomic_compare_exchange_n(&slot->seq, &expected, pos + LOG_RING_SLOTS, 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                if (seq & RING_SEQ_CLAIMED) __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+                pos++;
+                *stall_since = 0;
+            }
+            continue;  // Pominięty albo producent zdążył zająć / opublikować slot - odczytaj ponownie
+        }
+        *stall_since = 0;
+
+        // Bufor prawie pełny - zapisz go zanim dopiszesz kolejny wpis
+        if (used + LOG_RECORD_MAX > sizeof(batch)) {
+            write_all(fd, batch, used);
+            used = 0;
+        }
+        used += append_record(&slot->rec, batch + used);
+        count++;
+
+        // Zwolnij slot dla następnego okrążenia
+        __atomic_store_n(&slot->seq, pos + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+        pos++;
+    }
+
+    if (used > 0) {
+        write_all(fd, batch, used);
+    }
+    ring->head = pos;
+    return count;
+}
+
+/*
+ * Funkcja writers_left - sprawdza ile procesów jest podłączonych do pierścienia
+ * (main i logger też się liczą)
+ */
+int writers_left() {
+    struct shmid_ds ds;
+    if (shmctl(logid, IPC_STAT, &ds) == -1) {
+        return 0;
+    }
+    return (int)ds.shm_nattch;
+}
+
+int main() {
+    // === INICJALIZACJA KLUCZY IPC ===
+    key_t shm_key = ftok(SHM_PATH, 'S');  // Klucz pamięci dzielonej
+    key_t log_key = ftok(SHM_PATH, LOG_RING_PROJ);  // Klucz pierścienia logów
+
+    if (shm_key == -1 || log_key == -1) {
+        perror("ftok");
+        return 1;
+    }
+
+    // === UZYSKANIE DOSTĘPU DO ZASOBÓW IPC ===
+    shmid = shmget(shm_key, sizeof(struct BusState), 0600);
+    logid = shmget(log_key, sizeof(struct LogRing), 0600);
+
+    if (shmid == -1 || logid == -1) {
+        perror("get ipc");
+        return 1;
+    }
+
+    bus = shmat(shmid, NULL, 0);
+    if (bus == (void*)-1) {
+        perror("shmat");
+        return 1;
+    }
+    ring = shmat(logid, NULL, 0);
+    if (ring == (void*)-1) {
+        perror("shmat log");
+        return 1;
+    }
+
+    // === IGNOROWANIE SIGINT ===
+    // Ctrl+C trafia do całej grupy procesów - logger musi dożyć do końca,
+    // żeby zapisać wpisy z zamykania systemu. Kończy się sam.
+    struct sigaction sai;
+    memset(&sai, 0, sizeof(sai));
+    sai.sa_handler = SIG_IGN;
+    sigemptyset(&sai.sa_mask);
+    sigaction(SIGINT, &sai, NULL);
+
+    int fd = open(bus->log_binary ? EV_REPORT_BIN : EV_REPORT_TXT, O_CREAT | O_WRONLY | O_APPEND, 0600);
+    if (fd == -1) {
+        perror("open report");
+        return 1;
+    }
+
+    // === GŁÓWNA PĘTLA LOGGERA ===
+    long long stall_since = 0;
+    for (;;) {
+        if (drain(fd, &stall_since) > 0) {
+            continue;  // Były wpisy - sprawdź od razu czy przybyły kolejne
+        }
+
+        // Pierścień pusty: kończymy gdy system się wyłącza
+        // i poza main oraz loggerem nikt nie jest podłączony
+        if (bus_shutting_down(bus) && writers_left() <= 2 && stall_since == 0) {
+            drain(fd, &stall_since);
+            break;
+        }
+
+        log_ring_sleep(ring, LOG_IDLE_SEC);  // Budzi producent, który opublikuje wpis
+    }
+
+    close(fd);
+    shmdt(ring);
+    shmdt(bus);
+    return 0;
+}
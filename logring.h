@@ -0,0 +1,225 @@
+/*
+ * LOGRING.H - Pierścień logów w pamięci dzielonej
+ *
+ * Zamiast otwierać report.txt przy każdym zdarzeniu (open/write/close),
+ * procesy wkładają rekordy zdarzeń (evlog.h) do bufora cyklicznego w osobnym
+ * segmencie pamięci dzielonej. Proces logger (logger.c) opróżnia bufor
+ * i zapisuje wpisy do pliku dużymi, sekwencyjnymi blokami.
+ *
+ * Bufor jest bez blokad (wielu producentów, jeden konsument):
+ * - producent rezerwuje pozycję przez CAS na 'tail', a potem slot przez CAS
+ *   na 'seq' (RING_SEQ_CLAIMED | pid) - dopiero wtedy kopiuje do niego dane,
+ * - każdy slot ma numer sekwencyjny 'seq' mówiący czy jest wolny/zapisany,
+ * - producent NIGDY nie czeka - gdy bufor jest pełny, wpis jest odrzucany
+ *   i liczony w 'dropped' (raportowane przez main przy zamykaniu),
+ * - logger przy pustym buforze śpi na futeksie 'sleeping'; budzi go
+ *   producent, który opublikował wpis (tylko gdy logger naprawdę śpi).
+ *
+ * Plik .c, który dołącza ten nagłówek, musi zdefiniować _DEFAULT_SOURCE
+ * (syscall() dla futeksu).
+ */
+
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "ipc.h"
+#include "evlog.h"
+
+#define LOG_RING_PROJ 'L'       // Znak dla ftok(SHM_PATH, ...) - osobny segment obok BusState
+#define LOG_RING_SLOTS 16384    // Liczba slotów (musi być potęgą dwójki)
+
+// === ZAJĘTY SLOT PIERŚCIENIA (logring.h, regring.h) ===
+// Producent, który zarezerwował pozycję, zajmuje slot CAS-em seq: pozycja ->
+// RING_SEQ_CLAIMED | pid i dopiero wtedy kopiuje dane. Konsument:
+// - slot zarezerwowany, ale niezajęty dłużej niż RING_STALL_SEC - pomija
+//   go (seq = pozycja + SLOTS); spóźniony producent widzi to przy CAS zajęcia,
+//   zanim cokolwiek zapisze, i bierze następną pozycję,
+// - slot zajęty - pomija go tylko gdy proces 'pid' już nie istnieje.
+#define RING_SEQ_CLAIMED (1UL << 63)  // Bit zajęcia w seq (młodsze bity: pid producenta)
+#define RING_STALL_SEC 1.0      // Co tyle sekund modelu konsument sprawdza niegotowy slot (jak TICKET_WAIT_SEC)
+
+/*
+ * Slot pierścienia - jeden rekord zdarzenia
+ *
+ * seq == pozycja          -> slot wolny, czeka na producenta
+ * seq == CLAIMED | pid    -> producent 'pid' kopiuje rekord
+ * seq == pozycja + 1      -> slot zapisany, czeka na konsumenta
+ * seq == pozycja + SLOTS  -> slot zwolniony przez konsumenta (następne okrążenie)
+ */
+struct LogSlot {
+    unsigned long seq;          // Numer sekwencyjny slotu
+    struct EvRecord rec;        // Zdarzenie
+};
+
+/*
+ * Struktura LogRing - pierścień logów w pamięci dzielonej
+ *
+ * 'tail' (producenci) i 'head' (konsument) leżą w osobnych liniach cache,
+ * żeby producenci nie unieważniali linii czytanej przez loggera.
+ */
+struct LogRing {
+    unsigned long tail;         // Następna pozycja do zarezerwowania przez producenta
+    char pad1[56];
+    unsigned long head;         // Następna pozycja do odczytu przez loggera
+    unsigned long dropped;      // Wpisy odrzucone (pełny bufor, slot procesu, który zginął w trakcie zapisu)
+    unsigned int sleeping;      // 1 = logger śpi na futeksie (producent musi go obudzić)
+    char pad2[44];
+    struct LogSlot slots[LOG_RING_SLOTS];
+};
+
+// === FUTEX (logring.h, regring.h) ===
+
+/*
+ * Funkcja ring_futex_wait - śpi dopóki *addr == val (najwyżej sec sekund modelu)
+ */
+static inline void ring_futex_wait(unsigned int* addr, unsigned int val, double sec, double scale) {
+    double rel = sec / scale;
+    struct timespec ts;
+    ts.tv_sec = (time_t)rel;
+    ts.tv_nsec = (long)((rel - ts.tv_sec) * 1e9);
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+/*
+ * Funkcja ring_futex_wake - budzi do n procesów śpiących na addr
+ */
+static inline void ring_futex_wake(unsigned int* addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+/*
+ * Funkcja ring_claim_word - wartość seq slotu zajętego przez ten proces
+ */
+static inline unsigned long ring_claim_word(void) {
+    return RING_SEQ_CLAIMED | (unsigned long)getpid();
+}
+
+/*
+ * Funkcja ring_owner_dead - czy producent zajętego slotu (seq z RING_SEQ_CLAIMED) nie żyje
+ */
+static inline int ring_owner_dead(unsigned long seq) {
+    return kill((pid_t)(seq & ~RING_SEQ_CLAIMED), 0) == -1 && errno == ESRCH;
+}
+
+/*
+ * Funkcja ring_stall_ns - RING_STALL_SEC w nanosekundach czasu rzeczywistego
+ */
+static inline long long ring_stall_ns(double scale) {
+    return (long long)(RING_STALL_SEC / scale * 1e9);
+}
+
+/*
+ * Funkcja log_ring_init - przygotowuje pusty pierścień (wywoływana tylko przez main)
+ */
+static inline void log_ring_init(struct LogRing* ring) {
+    memset(ring, 0, sizeof(*ring));
+    for (unsigned long i = 0; i < LOG_RING_SLOTS; i++) {
+        ring->slots[i].seq = i;  // Każdy slot wolny dla pierwszego okrążenia
+    }
+}
+
+/*
+ * Funkcja log_ring_attach - podłącza segment pierścienia logów
+ *
+ * Zwraca wskaźnik do pierścienia albo NULL jeśli segment nie istnieje
+ * (wtedy procesy zapisują logi bezpośrednio do pliku).
+ */
+static inline struct LogRing* log_ring_attach(void) {
+    key_t key = ftok(SHM_PATH, LOG_RING_PROJ);
+    if (key == -1) return NULL;
+    int id = shmget(key, sizeof(struct LogRing), 0600);
+    if (id == -1) return NULL;
+    void* p = shmat(id, NULL, 0);
+    if (p == (void*)-1) return NULL;
+    return (struct LogRing*)p;
+}
+
+/*
+ * Funkcja log_ring_push - wkłada rekord zdarzenia do pierścienia
+ *
+ * Zwraca:
+ *   0 - wpis zapisany
+ *  -1 - bufor pełny, wpis odrzucony
+ *
+ * Nie blokuje (wywołania systemowe: getpid() przy zajęciu slotu i futex
+ * tylko gdy logger śpi) - można jej używać także w handlerach sygnałów.
+ */
+static inline int log_ring_push(struct LogRing* ring, const struct EvRecord* e) {
+    unsigned long pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    struct LogSlot* slot;
+
+    for (;;) {
+        slot = &ring->slots[pos & (LOG_RING_SLOTS - 1)];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - pos);
+        if (seq & RING_SEQ_CLAIMED) {
+            // Slot zapisuje inny producent: z tego okrążenia (tail już dalej)
+            // albo z poprzedniego (bufor pełny)
+            unsigned long t = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+            diff = t == pos ? -1 : 1;
+        }
+
+        if (diff == 0) {
+            // Slot wolny - próbujemy zarezerwować pozycję, a potem zająć slot
+            if (!__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, 0,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                continue;  // CAS nieudany - 'pos' zawiera aktualny tail
+            }
+            unsigned long expected = pos;
+            if (__atomic_compare_exchange_n(&slot->seq, &expected, ring_claim_word(), 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // Logger pominął slot (rezerwacja czekała zbyt długo) - następna pozycja
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+        else if (diff < 0) {
+            // Bufor pełny - logger nie nadąża, odrzucamy wpis
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    // Slot jest nasz - logger go nie pominie, dopóki żyjemy
+    slot->rec = *e;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // Logger śpi? Budzimy go (bariera: nasz zapis przed odczytem flagi,
+    // tak samo po stronie loggera - jedno z nas na pewno zobaczy drugie)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->sleeping, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&ring->sleeping, 0, __ATOMIC_ACQ_REL)) {
+        ring_futex_wake(&ring->sleeping, 1);
+    }
+    return 0;
+}
+
+/*
+ * Funkcja log_ring_sleep - logger przy pustym pierścieniu śpi do pobudki
+ * (opublikowany wpis) albo najwyżej sec sekund
+ */
+static inline void log_ring_sleep(struct LogRing* ring, double sec) {
+    __atomic_store_n(&ring->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    struct LogSlot* slot = &ring->slots[ring->head & (LOG_RING_SLOTS - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == ring->head + 1) {
+        __atomic_store_n(&ring->sleeping, 0, __ATOMIC_RELAXED);  // Zdążył przyjść wpis
+        return;
+    }
+    ring_futex_wait(&ring->sleeping, 1, sec, 1.0);
+    __atomic_store_n(&ring->sleeping, 0, __ATOMIC_RELAXED);
+}
+
+#endif
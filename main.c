@@ -3,18 +3,21 @@
  * 
  * Ten proces jest punktem startowym całego systemu.
  * Główne zadania:
- * - Parsowanie parametrów wiersza poleceń (N, P, R, T)
+ * - Parsowanie parametrów wiersza poleceń (N, P, R, T oraz opcji)
  * - Tworzenie zasobów IPC (pamięć dzielona, semafory, kolejka komunikatów)
  * - Inicjalizacja struktury BusState
  * - Uruchamianie wszystkich procesów potomnych:
+ *   * 1 logger (logger) - zapis logów z pierścienia do report.txt
  *   * N kierowców (driver)
- *   * 1 kasjer (cashier)
+ *   * C okienek kasy (cashier, domyślnie 1)
  *   * 1 dyspozytor (dispatcher)
  *   * 1 generator pasażerów (passenger_generator)
  * - Oczekiwanie na zakończenie wszystkich procesów
  * - Sprzątanie zasobów IPC po zakończeniu
  */
 
+#define _DEFAULT_SOURCE  // wait4() - zużycie zasobów każdego zebranego procesu; syscall() (regring.h)
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -25,51 +28,52 @@
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
 #include <string.h>
+#include <limits.h>
 #include "ipc.h"
+#include "logring.h"
+#include "stats.h"
+#include "buslock.h"
+#include "timescale.h"
+#include "policy.h"
+#include "regring.h"
 
 // Globalne zmienne potrzebne do cleanup i obsługi sygnałów
-int shmid, semid, msgid;  // ID zasobów IPC
+int shmid, semid, msgid, logid = -1, statsid = -1, regid = -1, replyid = -1;  // ID zasobów IPC
 struct BusState* bus;  // Wskaźnik do pamięci dzielonej
+struct LogRing* logring;  // Pierścień logów (NULL = zapis bezpośrednio do pliku)
+struct BusStats* stats;  // Segment statystyk dla busstat (NULL = brak)
+struct RegRing* regring;  // Pierścień rejestracji (--reg-ring, NULL = kolejka komunikatów)
 pid_t dispatcher_pid = 0;  // PID dyspozytora (do wysyłania sygnałów)
+pid_t logger_pid = 0, generator_pid = 0, exporter_pid = 0;  // PID-y do rozliczenia zużycia zasobów
+pid_t cashier_pids[MAX_CASHIERS];
 
-/*
- * Funkcja log_write - zapisuje wpis do pliku report.txt
- * Parametry:
- *   s - tekst do zapisania
- */
-void log_write(const char* s) {
-    int fd = open("report.txt", O_CREAT | O_WRONLY | O_APPEND, 0600);
-    if (fd == -1) {
-        perror("open report");
-        return;
-    }
-    if (write(fd, s, strlen(s)) == -1) {
-        perror("write report");
-    }
-    if (close(fd) == -1) {
-        perror("close report");
-    }
-}
+// Zużycie zasobów zakończonych procesów potomnych, według komponentu (evlog.h)
+long comp_cpu_us[EV_COMP_COUNT];  // Czas CPU (user + sys)
+long comp_csw[EV_COMP_COUNT];  // Przełączenia kontekstu (dobrowolne + wymuszone)
+int comp_procs[EV_COMP_COUNT];  // Liczba procesów
 
 /*
- * Funkcja ts (timestamp) - generuje aktualny znacznik czasu
+ * Funkcja log_event - zgłasza zdarzenie do raportu
  * Parametry:
- *   buf - bufor na wynik w formacie HH:MM:SS
- *   n - rozmiar bufora
+ *   e - rekord zdarzenia (czas i PID uzupełniane automatycznie)
+ *
+ * Rekord trafia do pierścienia logów w pamięci dzielonej; bezpośredni
+ * zapis do pliku tylko gdy pierścień jest niedostępny
  */
-void ts(char* buf, size_t n) {
-    time_t t = time(NULL);  // Pobierz aktualny czas systemowy
-    struct tm* tm_info = localtime(&t);  // Konwertuj na czas lokalny
-    if (tm_info == NULL) {
-        snprintf(buf, n, "00:00:00");  // Wartość domyślna w razie błędu
+void log_event(struct EvRecord e) {
+    e.ts_ns = ev_now_ns();
+    if (e.pid == 0) e.pid = getpid();
+    if (logring) {
+        log_ring_push(logring, &e);  // Nie blokuje - zapis wykona logger
         return;
     }
-    strftime(buf, n, "%H:%M:%S", tm_info);  // Formatuj jako HH:MM:SS
+    ev_append(&e, bus->log_binary, bus->clock_offset_ns);
 }
 
 /*
@@ -91,60 +95,282 @@ void cleanup() {
     if (msgctl(msgid, IPC_RMID, NULL) == -1) {
         perror("msgctl IPC_RMID");
     }
+    if (logid != -1 && shmctl(logid, IPC_RMID, NULL) == -1) {
+        perror("shmctl IPC_RMID log");
+    }
+    if (statsid != -1 && shmctl(statsid, IPC_RMID, NULL) == -1) {
+        perror("shmctl IPC_RMID stats");
+    }
+    if (regid != -1 && shmctl(regid, IPC_RMID, NULL) == -1) {
+        perror("shmctl IPC_RMID reg ring");
+    }
+    if (replyid != -1 && shmctl(replyid, IPC_RMID, NULL) == -1) {
+        perror("shmctl IPC_RMID reply table");
+    }
     // Usuń pliki kluczy
     unlink(SHM_PATH);
     unlink(SEM_PATH);
     unlink(MSG_PATH);
 }
 
+/*
+ * Funkcja flush_log_ring - dopisuje do pliku wpisy pozostawione w pierścieniu
+ *
+ * Wywoływana po zakończeniu loggera (np. wpisy pasażerów, którzy zakończyli
+ * się po nim). Od tej chwili main pisze logi bezpośrednio do pliku.
+ * Zwraca liczbę wpisów odrzuconych przez pierścień w trakcie działania.
+ */
+unsigned long flush_log_ring() {
+    if (!logring) return 0;
+    struct LogRing* ring = logring;
+    logring = NULL;  // Kolejne log_event piszą bezpośrednio do pliku
+
+    unsigned long pos = ring->head;
+    for (;;) {
+        struct LogSlot* slot = &ring->slots[pos & (LOG_RING_SLOTS - 1)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) break;
+        ev_append(&slot->rec, bus->log_binary, bus->clock_offset_ns);
+        pos++;
+    }
+
+    unsigned long dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    shmdt(ring);
+    return dropped;
+}
+
+/*
+ * Funkcja wake_cashiers - budzi okienka kasy śpiące w blokującym msgrcv()
+ * Wysyła po jednej pustej rejestracji (pid = MSG_WAKEUP_PID) na okienko;
+ * IPC_NOWAIT, bo wołana z handlera sygnału - przy pełnej kolejce kasjerzy
+ * i tak są zajęci. Przy --reg-ring okienka śpią na futeksie pierścienia.
+ */
+void wake_cashiers() {
+    if (regring) {
+        reg_ring_kick(regring, bus->cashiers);
+        return;
+    }
+    struct msg w;
+    memset(&w, 0, sizeof(w));
+    w.type = MSG_REGISTER;
+    w.pid = MSG_WAKEUP_PID;
+    int n = bus ? bus->cashiers : 1;
+    for (int i = 0; i < n; i++) {
+        msgsnd(msgid, &w, sizeof(w) - sizeof(long), IPC_NOWAIT);
+    }
+}
+
+/*
+ * Funkcja room_post - podnosi semafor poczekalni o n
+ * sem_op jest typu short: więcej niż SHRT_MAX czekających budzimy porcjami
+ * (jądro od razu oddaje każdą porcję śpiącym, więc semafor nie rośnie).
+ * Przestajemy przy błędzie (ERANGE - wartość przekroczyłaby SEMVMX).
+ */
+void room_post(int room, int n) {
+    while (n > 0) {
+        short op = n > SHRT_MAX ? SHRT_MAX : (short)n;
+        struct sembuf sb = { room, op, 0 };
+        if (semop(semid, &sb, 1) == -1) return;
+        n -= op;
+    }
+}
+
+/*
+ * Funkcja wake_waiting_room - budzi pasażerów czekających w poczekalni
+ * Wołana z handlera sygnału, więc bez mutexu - liczniki czytamy atomowo.
+ * Nadmiarowe podniesienie semafora przy shutdown niczego nie psuje.
+ */
+void wake_waiting_room() {
+    room_post(SEM_ROOM, __atomic_load_n(&bus->waiting, __ATOMIC_ACQUIRE));
+    room_post(SEM_ROOM_BIKE, __atomic_load_n(&bus->waiting_bikes, __ATOMIC_ACQUIRE));
+}
+
+/*
+ * Funkcja ring_platforms - dzwoni na wszystkich stanowiskach (shutdown)
+ * Kierowcy czekający na postoju odjeżdżają od razu zamiast czekać do końca T
+ */
+void ring_platforms() {
+    for (int i = 0; i < bus->platforms; i++) {
+        struct sembuf sb = { SEM_DWELL + i, 1, 0 };
+        semop(semid, &sb, 1);
+    }
+}
+
+/*
+ * Funkcja report_cashier_load - rozkład rejestracji między okienka kasy
+ * Wołana po zakończeniu wszystkich procesów; zapisuje do raportu
+ * liczbę rejestracji i udział każdego okienka
+ */
+void report_cashier_load() {
+    long total = 0;
+    for (int i = 0; i < bus->cashiers; i++) {
+        total += bus->window[i].registrations;
+    }
+    for (int i = 0; i < bus->cashiers; i++) {
+        long reg = bus->window[i].registrations;
+        int permille = total > 0 ? (int)(reg * 1000 / total) : 0;
+        log_event((struct EvRecord){ .type = EV_MAIN_CASHIER_LOAD, .arg = i, .arg2 = (int)reg, .passengers = (int16_t)permille });
+    }
+}
+
+/*
+ * Funkcja fmt_ns - czas w ns jako tekst z jednostką (ns/us/ms/s)
+ */
+void fmt_ns(char* buf, size_t n, uint64_t ns) {
+    if (ns < 1000) snprintf(buf, n, "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000) snprintf(buf, n, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, n, "%.1fms", ns / 1e6);
+    else snprintf(buf, n, "%.2fs", ns / 1e9);
+}
+
+/*
+ * Funkcja print_hist_row - wiersz tabeli: liczba próbek i percentyle
+ */
+void print_hist_row(const char* stage, const char* cls, const unsigned long* c) {
+    static const int permille[] = { 500, 900, 990, 999 };
+    unsigned long total = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) total += c[b];
+    if (total == 0) return;
+    printf("%-24s %-14s %8lu", stage, cls, total);
+    for (int i = 0; i < 4; i++) {
+        char buf[32];
+        fmt_ns(buf, sizeof(buf), hist_percentile(c, total, permille[i]));
+        printf(" %10s", buf);
+    }
+    printf("\n");
+}
+
+/*
+ * Funkcja report_latency - tabela percentyli opóźnień pasażerów
+ * Wołana po zakończeniu wszystkich procesów: dla każdego etapu wiersz
+ * "wszyscy" (suma klas), potem wiersze klas z co najmniej jedną próbką
+ */
+void report_latency() {
+    static const char* const class_names[HIST_CLASSES] = {
+        "zwykly", "vip", "rower", "vip+rower",
+        "dziecko", "vip+dziecko", "rower+dziecko", "vip+rower+dz"
+    };
+    printf("\n=== OPOZNIENIA PASAZEROW (czas rzeczywisty) ===\n");
+    printf("%-24s %-14s %8s %10s %10s %10s %10s\n", "etap", "klasa", "liczba", "p50", "p90", "p99", "p99.9");
+    for (int s = 0; s < HIST_STAGES; s++) {
+        unsigned long all[HIST_BUCKETS] = { 0 };
+        for (int c = 0; c < HIST_CLASSES; c++) {
+            for (int b = 0; b < HIST_BUCKETS; b++) all[b] += bus->hist.count[s][c][b];
+        }
+        print_hist_row(hist_stage_names[s], "wszyscy", all);
+        for (int c = 0; c < HIST_CLASSES; c++) {
+            print_hist_row("", class_names[c], bus->hist.count[s][c]);
+        }
+    }
+}
+
 /*
  * Handler sygnału SIGINT (Ctrl+C)
  * 
  * Inicjuje kontrolowane zamknięcie systemu:
- * 1. Ustawia flagi shutdown i station_blocked w pamięci dzielonej
- * 2. Wysyła SIGINT do dyspozytora
+ * 1. Ustawia flagi shutdown i blokady dworca w słowie sterującym (bus_control_set)
+ * 2. Wysyła SIGINT do dyspozytora, budzi kasjerów, poczekalnię i kierowców na postoju
  * 3. Loguje rozpoczęcie zamykania
  */
 void handle_sigint(int sig) {
     (void)sig;
     if (bus) {
-        bus->shutdown = 1;  // Rozpocznij wyłączanie systemu
-        bus->station_blocked = 1;  // Zablokuj dworzec
+        bus_control_set(bus, CTRL_SHUTDOWN | CTRL_BLOCKED);  // Wyłączanie + blokada dworca, jedna operacja
     }
     
     if (dispatcher_pid > 0) {
         kill(dispatcher_pid, SIGINT);  // Powiadom dyspozytora
     }
+    wake_cashiers();  // Kasjerzy śpią w msgrcv() - niech sprawdzą shutdown
+    if (bus) {
+        wake_waiting_room();  // Pasażerowie w poczekalni też muszą zobaczyć shutdown
+        ring_platforms();  // Kierowcy na postoju też
+    }
     
-    char b[64];
-    ts(b, sizeof(b));
-    char ln[128];
-    snprintf(ln, sizeof(ln), "[%s] [MAIN] Shutdown initiated\n", b);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_MAIN_SHUTDOWN });
+}
+
+/*
+ * Funkcja account_child - dolicza zużycie zasobów zakończonego procesu
+ * Parametry:
+ *   pid - PID zebranego procesu potomnego
+ *   ru - jego zużycie zasobów z wait4() (razem z jego zebranymi potomkami -
+ *        dla generatora to także wszyscy pasażerowie)
+ */
+void account_child(pid_t pid, const struct rusage* ru) {
+    int c = EV_COMP_DRIVERS;  // Pozostali potomkowie to kierowcy
+    if (pid == logger_pid) c = EV_COMP_LOGGER;
+    else if (pid == dispatcher_pid) c = EV_COMP_DISPATCHER;
+    else if (pid == generator_pid) c = EV_COMP_PASSENGERS;
+    else if (pid == exporter_pid) c = EV_COMP_EXPORTER;
+    else {
+        for (int i = 0; i < MAX_CASHIERS; i++) {
+            if (cashier_pids[i] == pid) c = EV_COMP_CASHIERS;
+        }
+    }
+    comp_cpu_us[c] += (ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1000000L +
+                      ru->ru_utime.tv_usec + ru->ru_stime.tv_usec;
+    comp_csw[c] += ru->ru_nvcsw + ru->ru_nivcsw;
+    comp_procs[c]++;
+}
+
+/*
+ * Funkcja report_rusage - zapisuje do raportu zużycie zasobów komponentów
+ * (czas CPU i przełączenia kontekstu; main - własne zużycie)
+ */
+void report_rusage() {
+    struct rusage self;
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+        comp_cpu_us[EV_COMP_MAIN] = (self.ru_utime.tv_sec + self.ru_stime.tv_sec) * 1000000L +
+                                    self.ru_utime.tv_usec + self.ru_stime.tv_usec;
+        comp_csw[EV_COMP_MAIN] = self.ru_nvcsw + self.ru_nivcsw;
+        comp_procs[EV_COMP_MAIN] = 1;
+    }
+    for (int c = 0; c < EV_COMP_COUNT; c++) {
+        if (comp_procs[c] == 0) continue;
+        log_event((struct EvRecord){ .type = EV_MAIN_RUSAGE, .passengers = (int16_t)c, .bikes = (int16_t)comp_procs[c],
+                                     .arg = (int)(comp_cpu_us[c] / 1000), .arg2 = (int)comp_csw[c] });
+    }
 }
 
 /*
  * Handler sygnału SIGCHLD
  * 
- * Automatycznie zbiera zakończone procesy potomne używając waitpid z WNOHANG.
- * To zapobiega powstawaniu procesów zombie.
+ * Automatycznie zbiera zakończone procesy potomne używając wait4 z WNOHANG
+ * (razem z ich zużyciem zasobów). To zapobiega powstawaniu procesów zombie.
  * SA_NOCLDSTOP oznacza że nie chcemy być powiadamiani o zatrzymanych procesach.
  */
 void handle_sigchld(int sig) {
     (void)sig;
     int saved_errno = errno;  // Zachowaj errno (handler może go zmienić)
-    while (waitpid(-1, NULL, WNOHANG) > 0);  // Zbierz wszystkie zakończone procesy
+    struct rusage ru;
+    pid_t p;
+    while ((p = wait4(-1, NULL, WNOHANG, &ru)) > 0) {  // Zbierz wszystkie zakończone procesy
+        account_child(p, &ru);
+    }
     errno = saved_errno;  // Przywróć errno
 }
 
 int main(int argc, char** argv) {
     // === PARSOWANIE ARGUMENTÓW WIERSZA POLECEŃ ===
     if (argc < 5) {
-        fprintf(stderr, "Uzycie: %s N P R T\n", argv[0]);
+        fprintf(stderr, "Uzycie: %s N P R T [opcje]\n", argv[0]);
         fprintf(stderr, "  N - liczba autobusow\n");
         fprintf(stderr, "  P - maksymalna liczba pasazerow w autobusie\n");
         fprintf(stderr, "  R - maksymalna liczba rowerow w autobusie\n");
         fprintf(stderr, "  T - czas oczekiwania na dworcu (sekundy)\n");
+        fprintf(stderr, "Opcje:\n");
+        fprintf(stderr, "  --binary-log - raport binarny report.bin (konwersja: ./busdump)\n");
+        fprintf(stderr, "  --passenger-pool K - K procesow obsluguje kolejnych pasazerow (bez fork na pasazera)\n");
+        fprintf(stderr, "  --platforms K - K stanowisk na dworcu (1-%d, domyslnie 1)\n", MAX_PLATFORMS);
+        fprintf(stderr, "  --cashiers C - C okienek kasy (1-%d, domyslnie 1)\n", MAX_CASHIERS);
+        fprintf(stderr, "  --time-scale X - czas X razy szybszy (np. 50; ulamkowe sekundy postoju i odstepow)\n");
+        fprintf(stderr, "  --arrival-rate X - pasazerowie X razy czesciej (domyslnie 1: co 1-3 s)\n");
+        fprintf(stderr, "  --seed S - ziarno losowan (ten sam S = te same cechy pasazerow i czasy podrozy)\n");
+        fprintf(stderr, "  --policy ZASADA[:X] - zasada odjazdu: fixed, full (domyslnie), minload[:L], headway[:H]\n");
+        fprintf(stderr, "  --adaptive-dwell MIN:MAX - dyspozytor dobiera postoj T z popytu w granicach MIN..MAX s\n");
+        fprintf(stderr, "  --reg-ring - rejestracje w kasie przez pierscien w pamieci dzielonej zamiast kolejki komunikatow\n");
+        fprintf(stderr, "  --metrics ADRES - eksporter metryk Prometheusa (sciezka gniazda UNIX albo port 127.0.0.1)\n");
+        fprintf(stderr, "  --virtual-time H - symulacja H godzin na wirtualnym zegarze (./sim, bez procesow)\n");
         return EXIT_FAILURE;
     }
 
@@ -160,13 +386,123 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    // === OPCJE DODATKOWE ===
+    int log_binary = 0;  // 1 = raport binarny report.bin
+    int pool_size = 0;  // Liczba procesów w puli pasażerów
+    int platforms = 1;  // Liczba stanowisk na dworcu
+    int cashiers = 1;  // Liczba okienek kasy
+    int virtual_time = 0;  // 1 = symulacja zdarzeń dyskretnych (./sim)
+    double time_scale = 1.0;  // Przyspieszenie czasu
+    double arrival_rate = 1.0;  // Mnożnik częstości przybyć
+    unsigned int seed = (unsigned)(time(NULL) ^ getpid());  // Ziarno (domyślnie losowe)
+    const char* metrics_addr = NULL;  // Gniazdo eksportera metryk (NULL = bez eksportera)
+    int policy = POLICY_FULL;  // Zasada odjazdu (policy.h)
+    double policy_arg = 0;  // Parametr zasady (0 = domyślny)
+    double dwell_min = 0, dwell_max = 0;  // Granice zmiennego postoju (0 = stały T)
+    int reg_ring = 0;  // 1 = pierścień rejestracji (regring.h)
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--binary-log") == 0) {
+            log_binary = 1;
+        }
+        else if (strcmp(argv[i], "--passenger-pool") == 0 && i + 1 < argc) {
+            pool_size = atoi(argv[++i]);
+            if (pool_size < 0) {
+                fprintf(stderr, "Niepoprawny rozmiar puli\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--platforms") == 0 && i + 1 < argc) {
+            platforms = atoi(argv[++i]);
+            if (platforms < 1 || platforms > MAX_PLATFORMS) {
+                fprintf(stderr, "Niepoprawna liczba stanowisk (1-%d)\n", MAX_PLATFORMS);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--cashiers") == 0 && i + 1 < argc) {
+            cashiers = atoi(argv[++i]);
+            if (cashiers < 1 || cashiers > MAX_CASHIERS) {
+                fprintf(stderr, "Niepoprawna liczba okienek kasy (1-%d)\n", MAX_CASHIERS);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--time-scale") == 0 && i + 1 < argc) {
+            time_scale = atof(argv[++i]);
+            if (time_scale <= 0 || time_scale > TIME_SCALE_MAX) {
+                fprintf(stderr, "Niepoprawne przyspieszenie czasu (0-%.0f)\n", TIME_SCALE_MAX);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--arrival-rate") == 0 && i + 1 < argc) {
+            arrival_rate = atof(argv[++i]);
+            if (arrival_rate <= 0) {
+                fprintf(stderr, "Niepoprawna czestosc przybyc (> 0)\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            if (policy_parse(argv[++i], &policy, &policy_arg) == -1) {
+                fprintf(stderr, "Nieznana zasada odjazdu: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--adaptive-dwell") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf:%lf", &dwell_min, &dwell_max) != 2 ||
+                dwell_min <= 0 || dwell_max < dwell_min) {
+                fprintf(stderr, "Niepoprawne granice postoju (MIN:MAX, 0 < MIN <= MAX)\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (strcmp(argv[i], "--reg-ring") == 0) {
+            reg_ring = 1;
+        }
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_addr = argv[++i];
+        }
+        else if (strcmp(argv[i], "--virtual-time") == 0 && i + 1 < argc) {
+            if (atof(argv[++i]) <= 0) {
+                fprintf(stderr, "Niepoprawny czas symulacji (godziny > 0)\n");
+                return EXIT_FAILURE;
+            }
+            virtual_time = 1;
+        }
+        else {
+            fprintf(stderr, "Nieznana opcja: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // === TRYB WIRTUALNEGO CZASU ===
+    // Cały system liczy jeden proces symulacji - bez IPC i bez procesów potomnych
+    if (virtual_time) {
+        argv[0] = "sim";
+        execv("./sim", argv);
+        perror("exec sim");
+        return EXIT_FAILURE;
+    }
+
     // === TWORZENIE PLIKU RAPORTU ===
     // Tworzymy pusty plik report.txt (lub czyścimy istniejący)
-    int fdrep = creat("report.txt", 0600);
+    // W trybie binarnym report.bin zaczyna się od nagłówka z przesunięciem zegara
+    int64_t clock_offset = ev_clock_offset();
+    int fdrep = creat(log_binary ? EV_REPORT_BIN : EV_REPORT_TXT, 0600);
     if (fdrep == -1) {
         perror("creat report");
         return EXIT_FAILURE;
     }
+    if (log_binary) {
+        struct EvFileHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, EV_MAGIC, sizeof(EV_MAGIC));
+        hdr.version = EV_VERSION;
+        hdr.record_size = sizeof(struct EvRecord);
+        hdr.clock_offset_ns = clock_offset;
+        if (write(fdrep, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) {
+            perror("write report header");
+        }
+    }
     close(fdrep);
 
     // === TWORZENIE PLIKÓW KLUCZY IPC ===
@@ -204,24 +540,117 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    // === TWORZENIE PIERŚCIENIA LOGÓW ===
+    // Osobny segment obok BusState; bez niego procesy piszą logi bezpośrednio
+    key_t log_key = ftok(SHM_PATH, LOG_RING_PROJ);
+    if (log_key != -1) {
+        logid = shmget(log_key, sizeof(struct LogRing), IPC_CREAT | 0600);
+    }
+    if (logid == -1) {
+        perror("shmget log");
+    }
+    else {
+        logring = shmat(logid, NULL, 0);
+        if (logring == (void*)-1) {
+            perror("shmat log");
+            logring = NULL;
+        }
+        else {
+            log_ring_init(logring);
+        }
+    }
+
+    // === TWORZENIE SEGMENTU STATYSTYK (busstat) ===
+    // Bez niego system działa normalnie, tylko busstat nie ma czego czytać.
+    // Wyjątek: --adaptive-dwell - dyspozytor mierzy popyt z tych liczników
+    key_t stats_key = ftok(SHM_PATH, STATS_PROJ);
+    if (stats_key != -1) {
+        statsid = shmget(stats_key, sizeof(struct BusStats), IPC_CREAT | 0600);
+    }
+    if (statsid == -1) {
+        perror("shmget stats");
+    }
+    else {
+        stats = shmat(statsid, NULL, 0);
+        if (stats == (void*)-1) {
+            perror("shmat stats");
+            stats = NULL;
+        }
+        else {
+            memset(stats, 0, sizeof(*stats));
+        }
+    }
+    if (!stats && dwell_max > 0) {
+        fprintf(stderr, "--adaptive-dwell wymaga segmentu statystyk - przerwano start\n");
+        cleanup();
+        return EXIT_FAILURE;
+    }
+
+    // === TWORZENIE SLOTÓW ODPOWIEDZI KASY ===
+    // Kasa wpisuje tu bilety (regring.h) - bez nich pasażer nie dostanie biletu
+    key_t reply_key = ftok(SHM_PATH, REPLY_PROJ);
+    if (reply_key != -1) {
+        replyid = shmget(reply_key, sizeof(struct ReplyTable), IPC_CREAT | 0600);
+    }
+    if (replyid == -1) {
+        perror("shmget reply table");
+        cleanup();
+        return EXIT_FAILURE;
+    }
+    struct ReplyTable* replies = shmat(replyid, NULL, 0);
+    if (replies == (void*)-1) {
+        perror("shmat reply table");
+        cleanup();
+        return EXIT_FAILURE;
+    }
+    memset(replies, 0, sizeof(*replies));  // Wszystkie sloty wolne
+    shmdt(replies);  // Sam main nie czeka na bilety
+
+    // === TWORZENIE PIERŚCIENIA REJESTRACJI (--reg-ring) ===
+    // W przeciwieństwie do pierścienia logów nie ma tu trybu awaryjnego -
+    // kasa i pasażerowie muszą używać tej samej drogi
+    if (reg_ring) {
+        key_t reg_key = ftok(SHM_PATH, REG_RING_PROJ);
+        if (reg_key != -1) {
+            regid = shmget(reg_key, sizeof(struct RegRing), IPC_CREAT | 0600);
+        }
+        if (regid == -1) {
+            perror("shmget reg ring");
+            cleanup();
+            return EXIT_FAILURE;
+        }
+        regring = shmat(regid, NULL, 0);
+        if (regring == (void*)-1) {
+            perror("shmat reg ring");
+            regring = NULL;
+            cleanup();
+            return EXIT_FAILURE;
+        }
+        reg_ring_init(regring);
+    }
+
     // === TWORZENIE SEMAFORÓW ===
-    // Tworzymy zestaw 4 semaforów:
+    // Tworzymy zestaw SEM_COUNT semaforów:
     // [0] - mutex do ochrony pamięci dzielonej
-    // [1] - gate bez roweru (kontroluje wejście pasażerów bez rowerów)
-    // [2] - gate z rowerem (kontroluje wejście pasażerów z rowerami)
-    // [3] - dworzec (zapewnia że tylko jeden autobus jest na dworcu)
-    semid = semget(sem_key, 4, IPC_CREAT | 0600);
+    // [1] - dworzec (SEM_STATION, semafor zliczający - tylu autobusów naraz, ile stanowisk)
+    // [2] - poczekalnia pasażerów bez roweru (SEM_ROOM)
+    // [3] - poczekalnia pasażerów z rowerem (SEM_ROOM_BIKE)
+    // [4..] - dzwonki stanowisk (SEM_DWELL + i) - budzą kierowcę na postoju
+    semid = semget(sem_key, SEM_COUNT, IPC_CREAT | 0600);
     if (semid == -1) {
         perror("semget");
         cleanup();
         return EXIT_FAILURE;
     }
 
-    // Inicjalizacja wartości semaforów (wszystkie = 1, czyli odblokowane)
+    // Inicjalizacja wartości semaforów
     semctl(semid, 0, SETVAL, 1);  // mutex
-    semctl(semid, 1, SETVAL, 1);  // gate bez roweru
-    semctl(semid, 2, SETVAL, 1);  // gate z rowerem
-    semctl(semid, 3, SETVAL, 1);  // dworzec (tylko jeden autobus)
+    semctl(semid, SEM_STATION, SETVAL, platforms);  // dworzec (K stanowisk)
+    semctl(semid, SEM_ROOM, SETVAL, 0);  // poczekalnia - pusta
+    semctl(semid, SEM_ROOM_BIKE, SETVAL, 0);  // poczekalnia z rowerem - pusta
+    for (int i = 0; i < MAX_PLATFORMS; i++) {
+        semctl(semid, SEM_DWELL + i, SETVAL, 0);  // dzwonki stanowisk - ciche
+    }
 
     // === TWORZENIE KOLEJKI KOMUNIKATÓW ===
     // Używana do komunikacji pasażer <-> kasjer
@@ -238,14 +667,47 @@ int main(int argc, char** argv) {
     bus->R = R;  // Maksymalna liczba rowerów
     bus->T = T;  // Czas oczekiwania
     bus->N = N;  // Liczba autobusów
-    bus->passengers = 0;  // Obecnie brak pasażerów w autobusie
-    bus->bikes = 0;  // Obecnie brak rowerów w autobusie
-    bus->departing = 0;  // Autobus nie odjeżdża
-    bus->station_blocked = 0;  // Dworzec otwarty
+    bus->log_binary = log_binary;  // Format raportu
+    bus->clock_offset_ns = clock_offset;  // Do odtwarzania czasu ściennego w raporcie
+    bus->pool_size = pool_size;  // Tryb obsługi pasażerów
+    bus->platforms = platforms;  // Liczba stanowisk
+    bus->cashiers = cashiers;  // Liczba okienek kasy
+    bus->time_scale = time_scale;  // Przyspieszenie czasu (timescale.h)
+    bus->seed = seed;  // Ziarno strumieni losowych (rng.h)
+    bus->arrival_rate = arrival_rate;  // Częstość przybyć pasażerów
+    bus->policy = policy;  // Zasada odjazdu (policy.h)
+    bus->policy_arg = policy_arg;
+    bus->dwell_min = dwell_min;  // Zmienny postój (dyspozytor)
+    bus->dwell_max = dwell_max;
+    bus->reg_ring = reg_ring;  // Droga rejestracji w kasie
+    memset(bus->window, 0, sizeof(bus->window));  // Liczniki okienek
+    memset(&bus->hist, 0, sizeof(bus->hist));  // Histogramy opóźnień (hist.h)
+    if (stats) {
+        stats->P = P;  // busstat liczy wypełnienie autobusów w %
+        stats->platforms = platforms;
+    }
+    for (int i = 0; i < MAX_PLATFORMS; i++) {
+        bus->platform[i].board = BOARD_DEPARTING;  // Brak autobusu - drzwi zamknięte
+        bus->platform[i].driver_pid = 0;  // Brak kierowcy na stanowisku
+    }
     bus->active_passengers = 0;  // Brak aktywnych pasażerów
     bus->boarded_passengers = 0;  // Nikt jeszcze nie wsiadł
-    bus->driver_pid = 0;  // Brak kierowcy na dworcu
-    bus->shutdown = 0;  // System włączony
+    bus->last_depart_ns = 0;  // Jeszcze żadnego odjazdu
+    bus->dwell_ms = T * 1000;  // Postój startowy; przy --adaptive-dwell w granicach MIN..MAX
+    if (dwell_max > 0) {
+        if (bus->dwell_ms < dwell_min * 1000) bus->dwell_ms = (int)(dwell_min * 1000);
+        if (bus->dwell_ms > dwell_max * 1000) bus->dwell_ms = (int)(dwell_max * 1000);
+    }
+    bus->waiting = 0;  // Poczekalnia pusta
+    bus->waiting_bikes = 0;
+    bus->control = 0;  // System włączony, dworzec otwarty, epoka 0
+    if (bus_lock_init(bus) == -1) {  // Mutex BusState (tylko make LOCK=futex)
+        fprintf(stderr, "Nie udalo sie zainicjalizowac mutexu BusState\n");
+        cleanup();
+        return EXIT_FAILURE;
+    }
+    // Wersja układu na końcu - narzędzie, które ją zobaczy, widzi też cały stan
+    __atomic_store_n(&bus->layout_version, BUS_LAYOUT_VERSION, __ATOMIC_RELEASE);
 
     // === KONFIGURACJA OBSŁUGI SYGNAŁÓW ===
     
@@ -265,13 +727,40 @@ int main(int argc, char** argv) {
     sa_chld.sa_flags = SA_RESTART | SA_NOCLDSTOP;  // SA_NOCLDSTOP = ignoruj zatrzymane procesy
     sigaction(SIGCHLD, &sa_chld, NULL);
 
+    // === TWORZENIE LOGGERA ===
+    // Uruchamiany jako pierwszy, żeby od początku opróżniał pierścień logów
+    if (logring) {
+        pid_t pl = fork();
+        if (pl == -1) {
+            perror("fork logger");
+            flush_log_ring();  // Bez loggera piszemy bezpośrednio do pliku
+        }
+        else if (pl == 0) {
+            execl("./logger", "logger", NULL);
+            perror("exec logger");
+            _exit(1);
+        }
+        logger_pid = pl;
+    }
+
     // === LOGOWANIE STARTU SYSTEMU ===
-    char b[64];
-    ts(b, sizeof(b));
-    char ln[256];
-    snprintf(ln, sizeof(ln), "[%s] [MAIN] Start systemu: N=%d P=%d R=%d T=%d\n", 
-             b, N, P, R, T);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_MAIN_START, .arg = N, .passengers = P, .bikes = R, .arg2 = T });
+    log_event((struct EvRecord){ .type = EV_MAIN_SEED, .arg = (int)seed });  // Do powtórzenia przebiegu
+
+    // === TWORZENIE EKSPORTERA METRYK ===
+    // Opcjonalny - kończy się sam po ustawieniu shutdown
+    if (metrics_addr) {
+        pid_t pe = fork();
+        if (pe == -1) {
+            perror("fork exporter");
+        }
+        else if (pe == 0) {
+            execl("./exporter", "exporter", metrics_addr, NULL);
+            perror("exec exporter");
+            _exit(1);
+        }
+        exporter_pid = pe;
+    }
 
     // === TWORZENIE KIEROWCÓW (N AUTOBUSÓW) ===
     for (int i = 0; i < N; i++) {
@@ -281,22 +770,32 @@ int main(int argc, char** argv) {
         }
         else if (p == 0) {
             // Kod procesu potomnego
-            execl("./driver", "driver", NULL);  // Zastąp proces programem driver
+            // Numer kierowcy (argv[1]) wyznacza jego strumień losowy
+            char ibuf[16];
+            snprintf(ibuf, sizeof(ibuf), "%d", i);
+            execl("./driver", "driver", ibuf, NULL);  // Zastąp proces programem driver
             perror("exec driver");  // Jeśli exec się nie powiedzie
             _exit(1);  // _exit (nie exit) w procesie potomnym
         }
         // Proces rodzica kontynuuje pętlę
     }
 
-    // === TWORZENIE KASJERA ===
-    pid_t p1 = fork();
-    if (p1 == -1) {
-        perror("fork cashier");
-    }
-    else if (p1 == 0) {
-        execl("./cashier", "cashier", NULL);
-        perror("exec cashier");
-        _exit(1);
+    // === TWORZENIE OKIENEK KASY ===
+    // Wszystkie okienka odbierają rejestracje z tej samej kolejki;
+    // numer okienka (argv[1]) wskazuje jego liczniki w BusState
+    for (int i = 0; i < cashiers; i++) {
+        pid_t p1 = fork();
+        if (p1 == -1) {
+            perror("fork cashier");
+        }
+        else if (p1 == 0) {
+            char wbuf[16];
+            snprintf(wbuf, sizeof(wbuf), "%d", i);
+            execl("./cashier", "cashier", wbuf, NULL);
+            perror("exec cashier");
+            _exit(1);
+        }
+        cashier_pids[i] = p1;
     }
 
     // === TWORZENIE DYSPOZYTORA ===
@@ -321,18 +820,55 @@ int main(int argc, char** argv) {
         perror("exec passenger_generator");
         _exit(1);
     }
+    generator_pid = p3;
 
     // === OCZEKIWANIE NA ZAKOŃCZENIE WSZYSTKICH PROCESÓW ===
-    // wait(NULL) czeka na zakończenie dowolnego procesu potomnego
-    // Pętla kontynuuje dopóki są jakieś procesy potomne
-    while (wait(NULL) > 0);
+    // wait4() czeka na zakończenie dowolnego procesu potomnego i zwraca
+    // jego zużycie zasobów. SIGCHLD blokujemy - procesy zbiera tylko ta
+    // pętla, więc handler nie przerwie rozliczania w połowie.
+    // Logger kończy się sam, gdy po shutdown zostaje tylko on i main
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &chld, NULL);
+    struct rusage ru;
+    pid_t done;
+    while ((done = wait4(-1, NULL, 0, &ru)) > 0 || (done == -1 && errno == EINTR)) {
+        if (done > 0) account_child(done, &ru);
+    }
+
+    // === ROZKŁAD OBCIĄŻENIA OKIENEK KASY, ZUŻYCIE ZASOBÓW, OPÓŹNIENIA ===
+    report_cashier_load();
+    report_rusage();
+    report_latency();
+
+    // === RAPORT UTRACONYCH WPISÓW LOGU ===
+    unsigned long dropped = flush_log_ring();
+    if (dropped > 0) {
+        fprintf(stderr, "Pierscien logow: odrzucono %lu wpisow\n", dropped);
+        log_event((struct EvRecord){ .type = EV_MAIN_LOG_DROPPED, .arg = (int)dropped });
+    }
+
+    // === RAPORT PORZUCONYCH SLOTÓW PIERŚCIENIA REJESTRACJI ===
+    if (regring) {
+        unsigned long abandoned = 0;
+        for (int w = 0; w < bus->cashiers; w++) {
+            abandoned += __atomic_load_n(&regring->q[w].abandoned, __ATOMIC_RELAXED);
+        }
+        if (abandoned > 0) {
+            fprintf(stderr, "Pierscien rejestracji: pominieto %lu porzuconych slotow\n", abandoned);
+            log_event((struct EvRecord){ .type = EV_MAIN_REG_ABANDONED, .arg = (int)abandoned });
+        }
+    }
 
     // === LOGOWANIE ZAKOŃCZENIA ===
-    ts(b, sizeof(b));
-    snprintf(ln, sizeof(ln), "[%s] [MAIN] System zakonczony\n", b);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_MAIN_END });
 
     // === ODŁĄCZENIE PAMIĘCI DZIELONEJ ===
+    if (stats) {
+        __atomic_store_n(&stats->done, 1, __ATOMIC_RELEASE);  // busstat kończy pracę
+        shmdt(stats);
+    }
     if (shmdt(bus) == -1) {
         perror("shmdt");
     }
@@ -2,6 +2,8 @@
  * PASSENGER.C - Proces Pasażera
  * 
  * Ten proces symuluje pojedynczego pasażera próbującego wsiąść do autobusu.
+ * W trybie puli (./passenger --worker FD) jeden proces obsługuje kolejno
+ * wielu pasażerów, których generator przekazuje przez potok.
  * 
  * Charakterystyka pasażera (losowana):
  * - Wiek (0-79 lat)
@@ -14,15 +16,20 @@
  * 2. Sprawdzenie czy dworzec jest otwarty
  * 3. Odrzucenie dzieci bez opiekuna (wiek < 8)
  * 4. Rejestracja w kasie
- * 5. Oczekiwanie na bilet (jeśli nie VIP)
- * 6. Obsługa pasażera z dzieckiem (fork procesu dziecka)
- * 7. Próby wsiadania do autobusu (pętla z czekaniem)
+ * 5. Oczekiwanie na bilet (jeśli nie VIP) - na własnym slocie odpowiedzi
+ *    w pamięci dzielonej (regring.h), z limitem czasu
+ * 6. Próby wsiadania do autobusu - brak miejsca = czekanie w poczekalni
+ *    aż kierowca następnego autobusu nas obudzi
+ *
+ * Dorosły z dzieckiem to jedna jednostka wsiadania: dziecko nie jest
+ * procesem, tylko drugim miejscem rezerwowanym w tym samym CAS co rodzic.
  * 
  * Synchronizacja:
- * - Semafory gate[1] i gate[2] kontrolują dostęp do autobusu
- * - Atomowe operacje sprawdzania miejsca i wsiadania
+ * - Atomowe operacje sprawdzania miejsca i wsiadania (CAS na słowie wsiadania)
  */
 
+#define _DEFAULT_SOURCE  // syscall() - futex slotu odpowiedzi (regring.h)
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -30,72 +37,94 @@
 #include <sys/shm.h>
 #include <sys/sem.h>
 #include <sys/msg.h>
-#include <sys/wait.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <errno.h>
 #include <string.h>
 #include <time.h>
 #include "ipc.h"
+#include "logring.h"
+#include "stats.h"
+#include "buslock.h"
+#include "timescale.h"
+#include "rng.h"
+#include "policy.h"
+#include "regring.h"
+#include "board.h"
+
+#define TICKET_WAIT_SEC 1       // Maksymalny czas jednego czekania na bilet na futeksie slotu (sekundy modelu)
+#define ROOM_WAIT_SEC 1         // Maksymalny czas jednego czekania w poczekalni (sekundy modelu)
 
 // Globalne ID zasobów IPC
 int shmid, semid, msgid;
 struct BusState* bus;
+struct LogRing* logring;  // Pierścień logów (NULL = zapis bezpośrednio do pliku)
+struct BusStats* stats;  // Segment statystyk (NULL = brak, stat_add nic nie robi)
+struct RegRing* regring;  // Pierścień rejestracji (NULL = kolejka komunikatów)
+struct ReplyTable* replies;  // Sloty odpowiedzi - tu kasa wpisuje bilet
 
 /*
- * Funkcja ts (timestamp) - generuje aktualny znacznik czasu
+ * Funkcja log_event - zgłasza zdarzenie do raportu
+ * Parametry:
+ *   e - rekord zdarzenia (czas, jeśli 0, i PID uzupełniane automatycznie)
+ *
+ * Rekord trafia do pierścienia logów w pamięci dzielonej; bezpośredni
+ * zapis do pliku tylko gdy pierścień jest niedostępny
  */
-void ts(char* buf, size_t n) {
-    time_t t = time(NULL);
-    struct tm* tm_info = localtime(&t);
-    if (tm_info == NULL) {
-        snprintf(buf, n, "00:00:00");
+void log_event(struct EvRecord e) {
+    if (e.ts_ns == 0) e.ts_ns = ev_now_ns();  // Wcześniejszy czas podaje tylko przybycie z puli
+    if (e.pid == 0) e.pid = getpid();
+    if (logring) {
+        log_ring_push(logring, &e);  // Nie blokuje - zapis wykona logger
         return;
     }
-    strftime(buf, n, "%H:%M:%S", tm_info);
+    ev_append(&e, bus->log_binary, bus->clock_offset_ns);
 }
 
 /*
- * Funkcja log_write - zapisuje wpis do pliku report.txt
+ * Handler sygnału SIGALRM - limit czasu czekania w poczekalni
+ * Nic nie robi: przerywa blokujący semop() (EINTR), po czym pasażer
+ * sprawdza czy system się nie wyłącza
  */
-void log_write(const char* s) {
-    int fd = open("report.txt", O_CREAT | O_WRONLY | O_APPEND, 0600);
-    if (fd == -1) return;
-    write(fd, s, strlen(s));
-    close(fd);
+void handle_alrm(int sig) {
+    (void)sig;
 }
 
 /*
- * Funkcja sem_lock - blokuje semafor mutex (sem[0])
+ * Funkcja sem_lock - blokuje mutex BusState (semafor sem[0] lub futex, buslock.h)
  */
 void sem_lock() {
-    struct sembuf sb = { 0, -1, SEM_UNDO };
-    semop(semid, &sb, 1);
+    bus_lock(bus, semid);  // Semafor SysV albo futex - patrz buslock.h
 }
 
 /*
- * Funkcja sem_unlock - odblokowuje semafor mutex (sem[0])
+ * Funkcja sem_unlock - odblokowuje mutex BusState
  */
 void sem_unlock() {
-    struct sembuf sb = { 0, 1, SEM_UNDO };
-    semop(semid, &sb, 1);
+    bus_unlock(bus, semid);
 }
 
 /*
- * Funkcja gate_lock - blokuje określoną bramkę
+ * Funkcja ring_if_full - budzi kierowcę, gdy nasze wejście zapełniło autobus
+ * (albo osiągnęło próg zasady odjazdu - policy_ring_load)
  * Parametry:
- *   gate - numer bramki (1 = bez roweru, 2 = z rowerem)
- */
-void gate_lock(int gate) {
-    struct sembuf sb = { gate, -1, SEM_UNDO };
-    semop(semid, &sb, 1);
-}
-
-/*
- * Funkcja gate_unlock - odblokowuje określoną bramkę
+ *   pl - stanowisko
+ *   before, after - słowo wsiadania przed i po naszym CAS
+ *
+ * Dzwoni tylko pasażer, który przekroczył próg (P pasażerów, R rowerów, L osób),
+ * więc na jeden postój przypada najwyżej jeden dzwonek na każdy próg.
  */
-void gate_unlock(int gate) {
-    struct sembuf sb = { gate, 1, SEM_UNDO };
-    semop(semid, &sb, 1);
+void ring_if_full(int pl, unsigned long long before, unsigned long long after) {
+    int P = bus->P;
+    int R = bus->R;
+    int L = policy_ring_load(bus->policy, P, bus->policy_arg);
+    int seats_full = BOARD_PASSENGERS(before) < P && BOARD_PASSENGERS(after) >= P;
+    int bikes_full = R > 0 && BOARD_BIKES(before) < R && BOARD_BIKES(after) >= R;
+    int load_reached = L > 0 && BOARD_PASSENGERS(before) < L && BOARD_PASSENGERS(after) >= L;
+    if (seats_full || bikes_full || load_reached) {
+        struct sembuf sb = { SEM_DWELL + pl, 1, 0 };  // Bez SEM_UNDO - to sygnał dla kierowcy
+        semop(semid, &sb, 1);
+    }
 }
 
 /*
@@ -111,369 +140,382 @@ void gate_unlock(int gate) {
  *   0 - system się wyłącza (koniec procesu)
  *  -1 - brak miejsca (spróbuj ponownie)
  * 
- * WAŻNE: Ta funkcja wykonuje ATOMOWĄ operację:
- * 1. Zablokuj bramkę (gate_lock)
- * 2. Sprawdź warunki (shutdown, departing, miejsce)
- * 3. Jeśli OK, zwiększ liczniki (passengers, bikes)
- * 4. Odblokuj bramkę (gate_unlock)
- * 
- * Dzięki temu nie może być sytuacji race condition gdzie dwóch
- * pasażerów jednocześnie sprawdza miejsce i obaj wchodzą przekraczając limit.
+ * Szybka ścieżka: wybór stanowiska (board_pick) i jeden CAS na jego
+ * słowie wsiadania, który naraz sprawdza limit P, limit R i flagę odjazdu,
+ * a przy sukcesie zwiększa oba liczniki. Dwóch pasażerów nie może wejść
+ * "na to samo miejsce" - CAS drugiego się nie powiedzie i wybierze
+ * stanowisko ponownie. Bez wywołań systemowych.
+ *
+ * Wolna ścieżka (nigdzie brak miejsca): pod mutexem zapisujemy się do
+ * poczekalni, po ponownym sprawdzeniu stanowisk - kierowca, który otwiera
+ * drzwi i budzi poczekalnię pod tym samym mutexem, na pewno nas policzy.
+ * Wywołujący musi potem wywołać wait_room().
  */
 int try_board(int bike, int with_child, int vip) {
     (void)vip;  // Parametr vip obecnie nieużywany
-    int gate = bike ? 2 : 1;  // Wybierz bramkę: 2 jeśli rower, 1 jeśli bez
-    
-    // ATOMOWA operacja: lock gate -> sprawdź warunki -> wsiądź/odrzuć -> unlock
-    gate_lock(gate);
-
-    // Odczytaj stan systemu (chronione mutexem)
-    sem_lock();
-    int sd = bus->shutdown;  // Czy system się wyłącza?
-    int sb = bus->station_blocked;  // Czy dworzec zablokowany?
-    int dep = bus->departing;  // Czy autobus odjeżdża?
-    int pass = bus->passengers;  // Ile pasażerów już w autobusie?
-    int bks = bus->bikes;  // Ile rowerów już w autobusie?
-    int P = bus->P;  // Limit pasażerów
-    int R = bus->R;  // Limit rowerów
-
-    // Nie możemy wsiąść - system zamknięty lub autobus odjeżdża
-    if (sd || sb ) {
-        sem_unlock();
-        gate_unlock(gate);
-        return 0;  // System się wyłącza - kończymy proces
-    }
-
-    // Sprawdzamy czy jest miejsce
     int needed_seats = with_child ? 2 : 1;  // Rodzic + dziecko = 2 miejsca
     int needed_bikes = bike ? 1 : 0;
+    unsigned long long add = BOARD_MAKE(needed_seats, needed_bikes);
+
+    for (;;) {
+        // Nie możemy wsiąść - system zamknięty
+        if (bus_closed(bus)) {
+            return 0;  // System się wyłącza - kończymy proces
+        }
 
-    if (pass + needed_seats > P || bks + needed_bikes > R || dep) {
-        // Brak miejsca w autobusie
+        // === SZYBKA ŚCIEŻKA: CAS ===
+        unsigned long long w = 0;
+        int pl = board_pick(bus->platform, bus->platforms, bus->P, bus->R, needed_seats, needed_bikes, &w);
+        if (pl != -1) {
+            if (board_enter(&bus->platform[pl].board, w, add)) {
+                stat_add(stats, ST_BOARDINGS, needed_seats);
+                stat_add(stats, ST_ON_BOARD, needed_seats);
+                ring_if_full(pl, w, w + add);
+                return 1;  // Sukces - wsiedliśmy
+            }
+            continue;  // Ktoś nas wyprzedził - wybierz stanowisko od nowa
+        }
+
+        // === WOLNA ŚCIEŻKA: POCZEKALNIA ===
+        sem_lock();
+        if (bus_closed(bus)) {
+            sem_unlock();
+            continue;  // Zamknięto przed zapisem - ostatnia pobudka poczekalni mogła już minąć
+        }
+        if (board_pick(bus->platform, bus->platforms, bus->P, bus->R, needed_seats, needed_bikes, &w) != -1) {
+            sem_unlock();
+            continue;  // Drzwi otworzyły się w międzyczasie - próbuj wsiąść
+        }
+        if (bike) bus->waiting_bikes++;
+        else bus->waiting++;
         sem_unlock();
-        gate_unlock(gate);
+        stat_add(stats, ST_WAITING, 1);  // Zmniejszane w wait_room()
         return -1;  // Brak miejsca - czekamy na następny autobus
     }
+}
 
-    // Wchodzimy - ATOMOWO zwiększamy liczniki
-    bus->passengers += needed_seats;
-    bus->bikes += needed_bikes;
+/*
+ * Funkcja wait_room - czekanie w poczekalni na następny autobus
+ * Parametry:
+ *   bike - czy pasażer ma rower (wybiera poczekalnię)
+ *
+ * Wołana po try_board() == -1 (pasażer jest już policzony w poczekalni).
+ * Wraca gdy kierowca nas obudzi albo po ROOM_WAIT_SEC - wtedy wypisujemy
+ * się z poczekalni, a wywołujący sprawdza shutdown i próbuje ponownie.
+ */
+void wait_room(int bike) {
+    int room = bike ? SEM_ROOM_BIKE : SEM_ROOM;
+    struct sembuf sb = { room, -1, 0 };  // Bez SEM_UNDO - to nie jest blokada
+
+    ts_alarm(ROOM_WAIT_SEC, bus->time_scale);
+    int r = semop(semid, &sb, 1);
+    ts_alarm(0, bus->time_scale);
+    stat_add(stats, ST_WAITING, -1);  // Opuszczamy poczekalnię (obudzeni albo limit czasu)
+    if (r == 0) return;  // Obudzeni przez kierowcę
+
+    // Limit czasu. Jeśli kierowca zdążył nas policzyć i podnieść semafor,
+    // zabieramy ten sygnał; w przeciwnym razie wypisujemy się z licznika.
+    // (Gdy zabierzemy sygnał innego pasażera, licznik zawyży się o 1 -
+    // następny kierowca obudzi jedną osobę za dużo, która wróci do poczekalni.)
+    sem_lock();
+    sb.sem_flg = IPC_NOWAIT;
+    if (semop(semid, &sb, 1) == -1) {
+        if (bike) bus->waiting_bikes--;
+        else bus->waiting--;
+    }
     sem_unlock();
-
-    gate_unlock(gate);
-    return 1;  // Sukces - wsiedliśmy
 }
 
-int main() {
-    // === INICJALIZACJA IPC ===
-    key_t shm_key = ftok(SHM_PATH, 'S');
-    key_t sem_key = ftok(SEM_PATH, 'E');
-    key_t msg_key = ftok(MSG_PATH, 'M');
-
-    if (shm_key == -1 || sem_key == -1 || msg_key == -1) {
-        perror("ftok");
-        return 1;
+/*
+ * Funkcja send_registration - rejestracja w kasie
+ * Parametry:
+ *   m - rejestracja; dla nie-VIP rezerwujemy slot odpowiedzi (m->reply),
+ *       do którego kasa wpisze bilet
+ *
+ * Rejestracja idzie pierścieniem (--reg-ring) albo kolejką komunikatów.
+ * Zwraca 0 albo -1 (system zamknięto zanim zwolnił się slot odpowiedzi,
+ * albo gdy pierścień był pełny, błąd msgsnd) - wtedy slot jest już zwolniony.
+ */
+int send_registration(struct msg* m) {
+    m->reply = -1;
+    m->reply_gen = 0;
+    if (!m->vip) {
+        // Wszystkie sloty zajęte = REPLY_SLOTS pasażerów czeka na bilet; śpimy aż kasa jakiś zwolni
+        m->reply = reply_claim_wait(replies, bus, m->pid, &m->reply_gen);
+        if (m->reply == -1) return -1;
     }
-
-    shmid = shmget(shm_key, sizeof(struct BusState), 0600);
-    semid = semget(sem_key, 4, 0600);
-    msgid = msgget(msg_key, 0600);
-
-    if (shmid == -1 || semid == -1 || msgid == -1) {
-        perror("get ipc");
-        return 1;
+    if (regring) {
+        if (reg_ring_push(regring, bus, m) == -1) {
+            // Shutdown przy pełnym pierścieniu - rejestracja nie dotarła
+            if (m->reply >= 0) reply_release(replies, m->reply, m->reply_gen);
+            return -1;
+        }
+        return 0;
     }
+    if (msgsnd(msgid, m, sizeof(*m) - sizeof(long), 0) == -1) {
+        perror("msgsnd register");
+        if (m->reply >= 0) reply_release(replies, m->reply, m->reply_gen);
+        return -1;
+    }
+    return 0;
+}
 
-    bus = shmat(shmid, NULL, 0);
-    if (bus == (void*)-1) {
-        perror("shmat");
-        return 1;
+/*
+ * Funkcja wait_ticket - czekanie na bilet w slocie odpowiedzi
+ * Parametry:
+ *   m - rejestracja (m->reply); chwila rejestracji w kasie trafia do m->reg_ns
+ *   ticket_ok - [wyjście] 1 = bilet, 0 = odmowa kasy (shutdown)
+ *
+ * Kasa budzi tylko właściciela slotu, więc czekanie nie zależy od liczby
+ * innych pasażerów czekających na bilet. Limit TICKET_WAIT_SEC chroni przed
+ * rejestracją wysłaną już po zakończeniu kasy.
+ * Zwraca 1 = odpowiedź kasy, 0 = zamknięcie systemu. Slot jest zwalniany
+ * w obu przypadkach.
+ */
+int wait_ticket(struct msg* m, int* ticket_ok) {
+    int got = 0;
+    for (;;) {
+        if (reply_wait(replies, m->reply, m->reply_gen, TICKET_WAIT_SEC, bus->time_scale)) {
+            *ticket_ok = replies->slot[m->reply].ticket_ok;
+            m->reg_ns = replies->slot[m->reply].reg_ns;
+            got = 1;
+            break;
+        }
+        // Minął limit czasu - sprawdź czy system się nie wyłącza
+        // (słowo sterujące - odczyt atomowy bez semafora)
+        if (bus_closed(bus)) {
+            break;
+        }
     }
+    reply_release(replies, m->reply, m->reply_gen);
+    return got;
+}
 
-    // === GENEROWANIE LOSOWYCH CECH PASAŻERA ===
-    // Inicjalizacja generatora liczb losowych (unikalny seed dla każdego pasażera)
-    srand((unsigned)(getpid() ^ time(NULL)));
+/*
+ * Funkcja record_board - dolicza wejście do histogramów opóźnień
+ * Parametry:
+ *   cls - klasa pasażera (hist_class)
+ *   arrive_ns, ticket_ns - chwile przybycia i otrzymania biletu
+ */
+void record_board(int cls, uint64_t arrive_ns, uint64_t ticket_ns) {
+    uint64_t now = ev_now_ns();
+    hist_add(&bus->hist, HIST_TICKET_BOARD, cls, now - ticket_ns);
+    hist_add(&bus->hist, HIST_TOTAL, cls, now - arrive_ns);
+}
 
-    int vip = (rand() % 100 == 0);  // 1% szans na VIP
-    int bike = rand() % 2;  // 50% szans na rower
-    int age = rand() % 80;  // Wiek 0-79
-    int with_child = (age >= 18 && rand() % 5 == 0);  // 20% dorosłych ma dziecko
+/*
+ * Funkcja leave_system - pasażer opuszcza system
+ * Licznik active_passengers zmieniany atomowo - bez semafora 0.
+ */
+void leave_system() {
+    __atomic_fetch_sub(&bus->active_passengers, 1, __ATOMIC_RELEASE);
+}
 
-    // Bufory na logi
-    char b[64];
-    char ln[256];
+/*
+ * Funkcja serve_passenger - obsługa jednego pasażera od przybycia do wyjścia
+ * Parametry:
+ *   id - identyfikator pasażera w raporcie i w kolejce biletów
+ *        (PID procesu albo numer nadany przez generator w trybie puli)
+ *   arrival - numer przybycia nadany przez generator (strumień losowy)
+ *   arrive_ns - chwila przybycia (ev_now_ns): w trybie puli czas zapisu do
+ *               potoku przez generator, 0 = teraz (osobny proces pasażera)
+ *
+ * Przechodzi całą ścieżkę pasażera: losowanie cech, rejestracja,
+ * bilet, wsiadanie. Zawsze zmniejsza active_passengers (leave_system)
+ * przed powrotem.
+ */
+int serve_passenger(int id, int arrival, uint64_t arrive_ns) {
+    // === GENEROWANIE LOSOWYCH CECH PASAŻERA ===
+    // Własny strumień pasażera: ziarno przebiegu + numer przybycia
+    struct Rng rng;
+    rng_init(&rng, bus->seed, RNG_PASSENGER, (uint32_t)arrival);
+    int vip = (rng_below(&rng, 100) == 0);  // 1% szans na VIP
+    int bike = rng_below(&rng, 2);  // 50% szans na rower
+    int age = rng_below(&rng, 80);  // Wiek 0-79
+    int with_child = (age >= 18 && rng_below(&rng, 5) == 0);  // 20% dorosłych ma dziecko
+    int cls = hist_class(vip, bike, with_child);  // Klasa w histogramach opóźnień
+    if (arrive_ns == 0) arrive_ns = ev_now_ns();  // Początek pomiaru czasu w systemie
 
     // === LOGOWANIE PRZYBYCIA ===
-    ts(b, sizeof(b));
-    snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] Przybycie (VIP=%d wiek=%d rower=%d dziecko=%d)\n", 
-             b, getpid(), vip, age, bike, with_child);
-    log_write(ln);
+    log_event((struct EvRecord){ .ts_ns = arrive_ns, .pid = id, .type = EV_PASSENGER_ARRIVE, .vip = vip, .age = age, .bike = bike, .child = with_child });
 
     // === SPRAWDZENIE CZY DWORZEC JEST OTWARTY ===
-    sem_lock();
-    int sb = bus->station_blocked;
-    int sd = bus->shutdown;
-    sem_unlock();
-
-    if (sb || sd) {
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] Dworzec zamkniety\n", b, getpid());
-        log_write(ln);
-        sem_lock();
-        bus->active_passengers--;  // Zmniejsz licznik aktywnych pasażerów
-        sem_unlock();
-        shmdt(bus);
+    if (bus_closed(bus)) {
+        log_event((struct EvRecord){ .pid = id, .type = EV_PASSENGER_CLOSED });
+        stat_add(stats, ST_CLOSED_REFUSED, 1);
+        leave_system();
         return 0;
     }
 
     // === ODRZUCENIE DZIECI BEZ OPIEKUNA ===
     // Dzieci poniżej 8 lat nie mogą podróżować same
     if (age < 8) {
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [DZIECKO %d] Bez opiekuna - odmowa\n", b, getpid());
-        log_write(ln);
-        sem_lock();
-        bus->active_passengers--;
-        sem_unlock();
-        shmdt(bus);
+        log_event((struct EvRecord){ .pid = id, .type = EV_CHILD_REFUSED });
+        stat_add(stats, ST_CHILD_REFUSED, 1);
+        leave_system();
         return 0;
     }
 
     // === REJESTRACJA W KASIE ===
     struct msg m;
     m.type = MSG_REGISTER;  // Typ komunikatu: rejestracja
-    m.pid = getpid();  // Nasz PID
+    m.pid = id;  // Nasz identyfikator (PID albo numer nadany przez generator)
     m.vip = vip;  // Status VIP
     m.bike = bike;  // Czy mamy rower
     m.child = 0;  // To nie jest dziecko (dzieci < 8 już odrzucone)
-    m.ticket_ok = vip ? 1 : 0;  // VIP automatycznie ma OK
+    m.family = with_child;  // Klasa histogramu liczona przez kasę
+    m.arrive_ns = arrive_ns;  // Kasa mierzy przybycie→rejestracja
+    m.reg_ns = 0;
 
     // Sprawdź shutdown przed wysłaniem
-    sem_lock();
-    sd = bus->shutdown;
-    sb = bus->station_blocked;
-    sem_unlock();
-
-    if (sd || sb) {
-        ts(b, sizeof(b));
-        snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] Dworzec zamkniety przed rejestracją\n", b, getpid());
-        log_write(ln);
-        sem_lock();
-        bus->active_passengers--;
-        sem_unlock();
-        shmdt(bus);
+    if (bus_closed(bus)) {
+        log_event((struct EvRecord){ .pid = id, .type = EV_PASSENGER_CLOSED_REG });
+        stat_add(stats, ST_CLOSED_REFUSED, 1);
+        leave_system();
         return 0;
     }
 
     // Wysłanie komunikatu rejestracyjnego do kasjera
-    if (msgsnd(msgid, &m, sizeof(m) - sizeof(long), 0) == -1) {
-        perror("msgsnd register");
-    }
+    uint64_t reg_ns = ev_now_ns();  // Początek pomiaru rejestracja→bilet
+    int registered = send_registration(&m) == 0;
+    uint64_t ticket_ns = ev_now_ns();  // VIP ma "bilet" od razu po rejestracji
 
     // === CZEKANIE NA BILET (JEŚLI NIE VIP) ===
     if (!vip) {
-        int got_ticket = 0;  // Flaga otrzymania biletu
-        int no_msg_count = 0;  // Licznik pustych prób
-
-        // Pętla oczekiwania na bilet
-        for (;;) {
-            long ticket_type = MSG_TICKET_REPLY + getpid();  // Unikalny typ dla naszego biletu
-            ssize_t rr = msgrcv(msgid, &m, sizeof(m) - sizeof(long), ticket_type, IPC_NOWAIT);
-            
-            if (rr >= 0) {
-                // Otrzymaliśmy bilet
-                got_ticket = 1;
-                break;
-            }
-
-            if (errno != ENOMSG) {
-                // Błąd inny niż "brak wiadomości"
-                perror("msgrcv ticket");
-                break;
-            }
-
-            // Sprawdź czy system się nie wyłącza
-            sem_lock();
-            sd = bus->shutdown;
-            sb = bus->station_blocked;
-            sem_unlock();
-
-            if (sd || sb) break;  // Jeśli shutdown, przerwij czekanie
-
-            // Kontrola częstotliwości sprawdzania
-            no_msg_count++;
-            if (no_msg_count > 100) {
-                sleep(1);  // Zaśnij jeśli długo czekamy
-                no_msg_count = 0;
-            }
-        }
+        int ticket_ok = 0;
+        int got_ticket = registered && wait_ticket(&m, &ticket_ok);
 
         // Jeśli nie dostaliśmy biletu, kończymy
-        if (!got_ticket || !m.ticket_ok) {
-            ts(b, sizeof(b));
-            snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] Brak biletu\n", b, getpid());
-            log_write(ln);
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
-            shmdt(bus);
+        if (!got_ticket || !ticket_ok) {
+            log_event((struct EvRecord){ .pid = id, .type = EV_PASSENGER_NO_TICKET });
+            leave_system();
             return 0;
         }
-    }
-
-    // === OBSŁUGA PASAŻERA Z DZIECKIEM ===
-    if (with_child) {
-        // Tworzymy pipe do synchronizacji z procesem dziecka
-        int pipefd[2];
-        if (pipe(pipefd) == -1) {
-            perror("pipe");
-        }
-
-        // Zwiększ licznik aktywnych pasażerów (dla dziecka)
-        sem_lock();
-        bus->active_passengers++;
-        sem_unlock();
-
-        // Fork - tworzenie procesu dziecka
-        pid_t cpid = fork();
-        if (cpid == -1) {
-            perror("fork child");
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
-        }
-        else if (cpid == 0) {
-            // === KOD PROCESU DZIECKA ===
-            // Proces dziecka - NIE rejestruje się w kasie, tylko czeka na rodzica
-            close(pipefd[1]);  // Zamknij koniec do zapisu
-
-            // Czekaj na sygnał od rodzica
-            char bufc;
-            read(pipefd[0], &bufc, 1);  // Blokuje do otrzymania danych
-            close(pipefd[0]);
-
-            // Dziecko wchodzi przez bramkę bez roweru (synchronicznie z rodzicem)
-            // Tylko po to żeby przejść przez gate - liczniki już zwiększone przez rodzica
-            gate_lock(1);
-            gate_unlock(1);
-
-            // Zmniejsz licznik aktywnych pasażerów
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
-
-            shmdt(bus);
-            return 0;  // Koniec procesu dziecka
+        ticket_ns = ev_now_ns();
+        if (bus->log_binary) {
+            // Tylko w report.bin (benchstat) - raport tekstowy bez linii na każdy bilet
+            log_event((struct EvRecord){ .pid = id, .type = EV_PASSENGER_TICKET, .arg = (int)((ticket_ns - reg_ns) / 1000) });
         }
-        else {
-            // === KOD PROCESU RODZICA ===
-            close(pipefd[0]);  // Zamknij koniec do odczytu
-
-            // Próbujemy wsiąść (rodzic + dziecko razem)
-            for (;;) {
-                int result = try_board(bike, 1, vip);  // with_child = 1
-
-                if (result == 0) {
-                    // System się wyłącza
-                    close(pipefd[1]);
-                    waitpid(cpid, NULL, 0);  // Poczekaj na dziecko
-                    sem_lock();
-                    bus->active_passengers -= 2;  // Rodzic + dziecko
-                    sem_unlock();
-                    shmdt(bus);
-                    return 0;
-                }
-
-                if (result == 1) {
-                    // Sukces - wsiedliśmy!
-                    write(pipefd[1], "X", 1);  // Powiadom dziecko
-                    close(pipefd[1]);
-                    waitpid(cpid, NULL, 0);  // Poczekaj aż dziecko przejdzie przez gate
-
-                    ts(b, sizeof(b));
-                    snprintf(ln, sizeof(ln), "[%s] [DOROSLY+DZIECKO %d] Wsiadl (VIP=%d rower=%d)\n", 
-                             b, getpid(), vip, bike);
-                    log_write(ln);
-
-                    sem_lock();
-                    bus->active_passengers -= 2;  // Zmniejsz licznik o 2
-                    sem_unlock();
-                    shmdt(bus);
-                    return 0;
-                }
-
-                // Brak miejsca (result == -1) - czekamy na następny autobus
-                sleep(1);
-
-                // Sprawdź shutdown
-                sem_lock();
-                sd = bus->shutdown;
-                sb = bus->station_blocked;
-                sem_unlock();
-
-                if (sd || sb) {
-                    close(pipefd[1]);
-                    waitpid(cpid, NULL, 0);
-                    sem_lock();
-                    bus->active_passengers -= 2;
-                    sem_unlock();
-                    shmdt(bus);
-                    return 0;
-                }
-            }
+        if (m.reg_ns != 0 && m.reg_ns <= ticket_ns) {
+            hist_add(&bus->hist, HIST_REG_TICKET, cls, ticket_ns - m.reg_ns);
         }
     }
 
-    // === ZWYKŁY PASAŻER - PRÓBUJEMY WSIĄŚĆ ===
+    // === PRÓBY WSIADANIA ===
+    // Rodzic z dzieckiem to jedna jednostka: dziecko jest daną (2 miejsca
+    // w jednym CAS), nie osobnym procesem - wsiadają razem albo wcale
     for (;;) {
-        int result = try_board(bike, 0, vip);  // with_child = 0
+        int result = try_board(bike, with_child, vip);
 
         if (result == 0) {
-            // System się wyłącza
-            ts(b, sizeof(b));
-            snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] System zamkniety\n", b, getpid());
-            log_write(ln);
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
-            shmdt(bus);
+            // System się wyłącza (rodzina kończy bez wpisu w raporcie)
+            if (!with_child) {
+                log_event((struct EvRecord){ .pid = id, .type = EV_PASSENGER_SYSTEM_CLOSED });
+                stat_add(stats, ST_CLOSED_REFUSED, 1);
+            }
+            leave_system();
             return 0;
         }
 
         if (result == 1) {
             // Sukces - wsiedliśmy
-            ts(b, sizeof(b));
-            snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] Wsiadl (VIP=%d rower=%d)\n", 
-                     b, getpid(), vip, bike);
-            log_write(ln);
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
-            shmdt(bus);
+            log_event((struct EvRecord){ .pid = id, .type = with_child ? EV_FAMILY_BOARD : EV_PASSENGER_BOARD,
+                                         .vip = vip, .bike = bike });
+            record_board(cls, arrive_ns, ticket_ns);
+            leave_system();
             return 0;
         }
 
-        // Brak miejsca (result == -1) - czekamy na następny autobus
-        sleep(1);
+        // Brak miejsca (result == -1) - czekamy w poczekalni na następny autobus
+        wait_room(bike);
 
         // Sprawdź shutdown podczas oczekiwania
-        sem_lock();
-        sd = bus->shutdown;
-        sb = bus->station_blocked;
-        sem_unlock();
-
-        if (sd || sb) {
-            ts(b, sizeof(b));
-            snprintf(ln, sizeof(ln), "[%s] [PASAZER %d] Dworzec zamkniety podczas oczekiwania\n", 
-                     b, getpid());
-            log_write(ln);
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
-            shmdt(bus);
+        if (bus_closed(bus)) {
+            if (!with_child) {
+                log_event((struct EvRecord){ .pid = id, .type = EV_PASSENGER_CLOSED_WAIT });
+                stat_add(stats, ST_CLOSED_REFUSED, 1);
+            }
+            leave_system();
             return 0;
         }
     }
 
     return 0;
 }
+
+int main(int argc, char** argv) {
+    // === INICJALIZACJA IPC ===
+    key_t shm_key = ftok(SHM_PATH, 'S');
+    key_t sem_key = ftok(SEM_PATH, 'E');
+    key_t msg_key = ftok(MSG_PATH, 'M');
+
+    if (shm_key == -1 || sem_key == -1 || msg_key == -1) {
+        perror("ftok");
+        return 1;
+    }
+
+    shmid = shmget(shm_key, sizeof(struct BusState), 0600);
+    semid = semget(sem_key, SEM_COUNT, 0600);
+    msgid = msgget(msg_key, 0600);
+
+    if (shmid == -1 || semid == -1 || msgid == -1) {
+        perror("get ipc");
+        return 1;
+    }
+
+    bus = shmat(shmid, NULL, 0);
+    if (bus == (void*)-1) {
+        perror("shmat");
+        return 1;
+    }
+    logring = log_ring_attach();  // Brak pierścienia nie jest błędem krytycznym
+    stats = stats_attach();  // Tak samo brak segmentu statystyk
+    replies = reply_table_attach();
+    if (!replies) {
+        perror("shmat reply table");
+        return 1;
+    }
+    if (bus->reg_ring) {
+        regring = reg_ring_attach();
+        if (!regring) {
+            perror("shmat reg ring");
+            return 1;
+        }
+    }
+
+    // === LIMIT CZASU CZEKANIA W POCZEKALNI ===
+    // SIGALRM bez SA_RESTART - przerywa blokujący semop() poczekalni
+    struct sigaction saa;
+    memset(&saa, 0, sizeof(saa));
+    saa.sa_handler = handle_alrm;
+    sigemptyset(&saa.sa_mask);
+    saa.sa_flags = 0;
+    sigaction(SIGALRM, &saa, NULL);
+
+    // === TRYB PULI (--worker FD) ===
+    // Proces obsługuje kolejnych pasażerów odczytywanych z potoku generatora.
+    // IPC podłączamy tylko raz.
+    if (argc > 2 && strcmp(argv[1], "--worker") == 0) {
+        int fd = atoi(argv[2]);
+        struct Arrival a;
+        for (;;) {
+            ssize_t r = read(fd, &a, sizeof(a));
+            if (r == (ssize_t)sizeof(a)) {
+                serve_passenger(a.id, a.id, a.arrive_ns);  // Oczekiwanie w potoku wlicza się do opóźnień
+                continue;
+            }
+            if (r == -1 && errno == EINTR) continue;
+            break;  // EOF - generator zamknął pulę
+        }
+        close(fd);
+    }
+    else {
+        // Tryb klasyczny: jeden proces = jeden pasażer (argv[1] = numer przybycia)
+        serve_passenger(getpid(), argc > 1 ? atoi(argv[1]) : 0, 0);
+    }
+
+    if (regring) shmdt(regring);
+    shmdt(replies);
+    shmdt(bus);
+    return 0;
+}
@@ -5,20 +5,23 @@
  * Główne zadania:
  * - Czekanie losowego czasu (1-3 sekundy)
  * - Tworzenie nowego procesu pasażera (fork + exec)
+ *   albo przekazanie pasażera do puli procesów (opcja --passenger-pool)
  * - Inkrementacja licznika active_passengers przed utworzeniem pasażera
- * - Monitorowanie flag shutdown i station_blocked
+ * - Monitorowanie słowa sterującego (shutdown, blokada dworca) - bez mutexu,
+ *   generator nie używa semafora 0 wcale
  * - Automatyczne zbieranie zakończonych procesów potomnych
  * 
  * Generator działa w nieskończonej pętli do momentu otrzymania
  * sygnału shutdown lub station_blocked.
  */
 
+#define _DEFAULT_SOURCE  // syscall() - pobudka loggera na futeksie pierścienia logów (logring.h)
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
-#include <sys/sem.h>
 #include <fcntl.h>
 #include <time.h>
 #include <string.h>
@@ -26,54 +29,33 @@
 #include <sys/wait.h>
 #include <errno.h>
 #include "ipc.h"
+#include "logring.h"
+#include "stats.h"
+#include "timescale.h"
+#include "rng.h"
 
 // Globalne ID zasobów IPC
-int shmid, semid;
+int shmid;
 struct BusState* bus;
+struct LogRing* logring;  // Pierścień logów (NULL = zapis bezpośrednio do pliku)
+struct BusStats* stats;  // Segment statystyk (NULL = brak, stat_add nic nie robi)
 
 /*
- * Funkcja ts (timestamp) - generuje aktualny znacznik czasu
+ * Funkcja log_event - zgłasza zdarzenie do raportu
  * Parametry:
- *   buf - bufor na wynik w formacie HH:MM:SS
- *   n - rozmiar bufora
+ *   e - rekord zdarzenia (czas i PID uzupełniane automatycznie)
+ *
+ * Rekord trafia do pierścienia logów w pamięci dzielonej; bezpośredni
+ * zapis do pliku tylko gdy pierścień jest niedostępny
  */
-void ts(char* buf, size_t n) {
-    time_t t = time(NULL);  // Pobierz aktualny czas systemowy
-    struct tm* tm_info = localtime(&t);  // Konwertuj na czas lokalny
-    if (tm_info == NULL) {
-        snprintf(buf, n, "00:00:00");  // Wartość domyślna w razie błędu
+void log_event(struct EvRecord e) {
+    e.ts_ns = ev_now_ns();
+    if (e.pid == 0) e.pid = getpid();
+    if (logring) {
+        log_ring_push(logring, &e);  // Nie blokuje - zapis wykona logger
         return;
     }
-    strftime(buf, n, "%H:%M:%S", tm_info);  // Formatuj jako HH:MM:SS
-}
-
-/*
- * Funkcja log_write - zapisuje wpis do pliku report.txt
- * Parametry:
- *   s - tekst do zapisania
- */
-void log_write(const char* s) {
-    int fd = open("report.txt", O_CREAT | O_WRONLY | O_APPEND, 0600);
-    if (fd == -1) return;
-    write(fd, s, strlen(s));
-    close(fd);
-}
-
-/*
- * Funkcja sem_lock - blokuje semafor mutex (sem[0])
- * Używana do zapewnienia wyłącznego dostępu do pamięci dzielonej
- */
-void sem_lock() {
-    struct sembuf sb = { 0, -1, SEM_UNDO };  // Operacja P (wait)
-    semop(semid, &sb, 1);
-}
-
-/*
- * Funkcja sem_unlock - odblokowuje semafor mutex (sem[0])
- */
-void sem_unlock() {
-    struct sembuf sb = { 0, 1, SEM_UNDO };  // Operacja V (signal)
-    semop(semid, &sb, 1);
+    ev_append(&e, bus->log_binary, bus->clock_offset_ns);
 }
 
 /*
@@ -97,6 +79,58 @@ void handle_sigchld(int sig) {
     errno = saved_errno;  // Przywróć errno
 }
 
+/*
+ * Funkcja start_pool - uruchamia pulę długo działających procesów pasażerów
+ * Parametry:
+ *   size - liczba procesów w puli
+ *
+ * Zwraca deskryptor końca do zapisu potoku przybyć albo -1 przy błędzie.
+ * Każdy proces puli czyta rekordy Arrival z potoku i obsługuje pasażerów
+ * jednego po drugim (./passenger --worker FD). Zamknięcie potoku przez
+ * generator oznacza koniec pracy puli.
+ */
+int start_pool(int size) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        perror("pipe pool");
+        return -1;
+    }
+
+    char fdarg[16];
+    snprintf(fdarg, sizeof(fdarg), "%d", fds[0]);
+
+    int started = 0;
+    for (int i = 0; i < size; i++) {
+        pid_t p = fork();
+        if (p == -1) {
+            perror("fork pool worker");
+            break;
+        }
+        if (p == 0) {
+            close(fds[1]);  // Proces puli tylko czyta
+            execl("./passenger", "passenger", "--worker", fdarg, NULL);
+            perror("exec passenger worker");
+            _exit(1);
+        }
+        started++;
+    }
+    close(fds[0]);  // Generator tylko zapisuje
+
+    if (started == 0) {
+        close(fds[1]);
+        return -1;
+    }
+
+    // Gdy wszystkie procesy puli zginą, write() zwróci EPIPE zamiast zabić generator
+    struct sigaction sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sa_handler = SIG_IGN;
+    sigemptyset(&sp.sa_mask);
+    sigaction(SIGPIPE, &sp, NULL);
+
+    return fds[1];
+}
+
 int main(int argc, char** argv) {
     (void)argc;  // Nie używamy argumentów
     (void)argv;
@@ -104,18 +138,16 @@ int main(int argc, char** argv) {
     // === INICJALIZACJA IPC ===
     // Generuj klucze na podstawie ścieżek plików
     key_t shm_key = ftok(SHM_PATH, 'S');  // Klucz pamięci dzielonej
-    key_t sem_key = ftok(SEM_PATH, 'E');  // Klucz semaforów
 
-    if (shm_key == -1 || sem_key == -1) {
+    if (shm_key == -1) {
         perror("ftok");
         return 1;
     }
 
     // Uzyskaj dostęp do zasobów IPC (bez tworzenia - IPC_CREAT)
     shmid = shmget(shm_key, sizeof(struct BusState), 0600);
-    semid = semget(sem_key, 4, 0600);
 
-    if (shmid == -1 || semid == -1) {
+    if (shmid == -1) {
         perror("get ipc");
         return 1;
     }
@@ -126,6 +158,8 @@ int main(int argc, char** argv) {
         perror("shmat");
         return 1;
     }
+    logring = log_ring_attach();  // Brak pierścienia nie jest błędem krytycznym
+    stats = stats_attach();  // Tak samo brak segmentu statystyk
 
     // === KONFIGURACJA HANDLERA SIGCHLD ===
     struct sigaction sa_chld;
@@ -140,40 +174,56 @@ int main(int argc, char** argv) {
     }
 
     // === LOGOWANIE STARTU ===
-    char b[64];
-    ts(b, sizeof(b));
-    char ln[128];
-    snprintf(ln, sizeof(ln), "[%s] [GENERATOR] Start - tworzy pasazerow w nieskonczonosc\n", b);
-    log_write(ln);
+    log_event((struct EvRecord){ .type = EV_GENERATOR_START });
+
+    // === URUCHOMIENIE PULI PASAŻERÓW ===
+    // W trybie puli nie tworzymy procesu dla każdego pasażera
+    int pool_fd = -1;  // Potok przybyć (-1 = fork + exec na pasażera)
+    int next_id = 0;  // Numer ostatniego przybycia (strumień losowy pasażera, id w puli)
+    if (bus->pool_size > 0) {
+        pool_fd = start_pool(bus->pool_size);
+    }
 
     // === INICJALIZACJA GENERATORA LICZB LOSOWYCH ===
-    // Używamy aktualnego czasu jako seed
-    srand((unsigned)time(NULL));
+    // Strumień generatora wyznacza tylko ziarno przebiegu (bus->seed)
+    struct Rng rng;
+    rng_init(&rng, bus->seed, RNG_GENERATOR, 0);
 
     // === GŁÓWNA PĘTLA GENERATORA ===
+    // Przybycia planujemy od poprzedniego terminu, nie od chwili obudzenia -
+    // czas fork()/exec() nie opóźnia kolejnych pasażerów
+    struct timespec next;  // Termin następnego przybycia
+    ts_now(&next);
     for (;;) {
         // === FAZA 1: LOSOWY ODSTĘP ===
-        // Losowy odstęp 1-3 sekundy między tworzeniem pasażerów
-        int delay = 1 + (rand() % 3);  // [1, 3]
-        sleep(delay);
+        // Losowy odstęp 1-3 sekundy modelu między tworzeniem pasażerów,
+        // skrócony --arrival-rate X razy
+        int delay = 1 + rng_below(&rng, 3);  // [1, 3]
+        ts_add(&next, delay / bus->arrival_rate, bus->time_scale);
+        while (ts_sleep_until(&next) == EINTR);  // SIGCHLD przerywa sen
 
         // === FAZA 2: SPRAWDZENIE SHUTDOWN ===
-        // Sprawdź czy system się nie wyłącza
-        sem_lock();
-        int sd = bus->shutdown;  // Flaga shutdown
-        int sb = bus->station_blocked;  // Flaga blokady dworca
-        sem_unlock();
-
-        if (sd || sb) {
+        // Sprawdź czy system się nie wyłącza (słowo sterujące - odczyt atomowy)
+        if (bus_closed(bus)) {
             break;  // Jeśli system się wyłącza, zakończ generator
         }
 
         // === FAZA 3: INKREMENTACJA LICZNIKA AKTYWNYCH PASAŻERÓW ===
         // WAŻNE: Zwiększamy licznik PRZED utworzeniem procesu pasażera
         // Dzięki temu main może śledzić ile pasażerów jeszcze działa
-        sem_lock();
-        bus->active_passengers++;
-        sem_unlock();
+        __atomic_fetch_add(&bus->active_passengers, 1, __ATOMIC_RELAXED);
+        int arrival = ++next_id;  // Numer przybycia - wyznacza strumień losowy pasażera
+        stat_add(stats, ST_ARRIVALS, 1);
+
+        // === FAZA 4: PRZEKAZANIE PASAŻERA DO PULI ===
+        if (pool_fd != -1) {
+            struct Arrival a = { arrival, ev_now_ns() };  // Przybycie teraz, nie przy odczycie z potoku
+            if (write(pool_fd, &a, sizeof(a)) != (ssize_t)sizeof(a)) {
+                perror("write pool");
+                __atomic_fetch_sub(&bus->active_passengers, 1, __ATOMIC_RELAXED);
+            }
+            continue;
+        }
 
         // === FAZA 4: TWORZENIE PROCESU PASAŻERA ===
         pid_t p = fork();  // Utwórz nowy proces
@@ -181,14 +231,14 @@ int main(int argc, char** argv) {
             // Fork się nie powiódł
             perror("fork passenger");
             // Zmniejsz licznik bo pasażer nie został utworzony
-            sem_lock();
-            bus->active_passengers--;
-            sem_unlock();
+            __atomic_fetch_sub(&bus->active_passengers, 1, __ATOMIC_RELAXED);
         }
         else if (p == 0) {
             // === KOD PROCESU POTOMNEGO (PASAŻERA) ===
             // Zastąp proces programem passenger
-            execl("./passenger", "passenger", NULL);
+            char abuf[16];
+            snprintf(abuf, sizeof(abuf), "%d", arrival);
+            execl("./passenger", "passenger", abuf, NULL);
             // Jeśli exec się nie powiedzie, wypisz błąd i zakończ
             perror("exec passenger");
             _exit(1);  // Użyj _exit (nie exit) w procesie potomnym
@@ -199,9 +249,16 @@ int main(int argc, char** argv) {
     }
 
     // === ZAKOŃCZENIE PRACY ===
-    ts(b, sizeof(b));
-    snprintf(ln, sizeof(ln), "[%s] [GENERATOR] Koniec pracy\n", b);
-    log_write(ln);
+    // Zamknięcie potoku kończy pracę puli - procesy obsłużą pasażerów
+    // już czekających w potoku i zakończą się po odczytaniu EOF
+    if (pool_fd != -1) {
+        close(pool_fd);
+    }
+
+    // Czekamy na wszystkich potomków (procesy puli / pasażerów), żeby main
+    // - czekający na generator - nie zakończył systemu przed nimi
+    while (wait(NULL) > 0 || errno == EINTR);
+    log_event((struct EvRecord){ .type = EV_GENERATOR_END });
 
     shmdt(bus);  // Odłącz pamięć dzieloną
     return 0;
@@ -0,0 +1,217 @@
+/*
+ * POLICY.H - Zasady odjazdu autobusu ze stanowiska (opcja --policy)
+ *
+ * Kierowca na postoju pyta zasadę o decyzję: odjechać teraz czy czekać,
+ * a jeśli czekać - najwyżej jak długo (do następnej decyzji zależnej od
+ * czasu). Decyzję zmieniają też zdarzenia: dzwonek stanowiska (pasażer,
+ * którego wejście przekroczyło próg - patrz policy_ring_load) i sygnały.
+ *
+ * Zasady:
+ * - fixed       - odjazd po T sekundach (lub wymuszony przez dyspozytora)
+ * - full        - odjazd po T albo od razu, gdy autobus pełny (P osób / R rowerów)
+ * - minload[:L] - po T odjazd dopiero z co najmniej L osobami (domyślnie P/2),
+ *                 pełny autobus od razu, najpóźniej po 2T
+ * - headway[:H] - równe odstępy H sekund między odjazdami z dworca (domyślnie
+ *                 (T + 6) / N - postój i średnia podróż podzielone na N autobusów),
+ *                 postój co najmniej 1 s, pełny autobus od razu, najpóźniej po 2T
+ *
+ * policy_decide to czysta funkcja stanu (liczniki ze słowa wsiadania, czasy),
+ * więc tę samą zasadę stosuje kierowca (driver.c) i symulacja (sim.c).
+ *
+ * Zmienny postój (--adaptive-dwell MIN:MAX): T zasad to bieżący postój
+ * z BusState (dwell_ms), który dyspozytor co sekundę modelu wyznacza
+ * z estymatora popytu (struct DwellEstimator) - krótszy w szczycie,
+ * dłuższy przy małym ruchu.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "ipc.h"
+
+// === ZASADY ===
+enum DepartPolicy {
+    POLICY_FIXED = 0,
+    POLICY_FULL,
+    POLICY_MIN_LOAD,
+    POLICY_HEADWAY,
+    POLICY_COUNT
+};
+
+static const char* const policy_names[POLICY_COUNT] = { "fixed", "full", "minload", "headway" };
+
+#define POLICY_MIN_DWELL 1.0    // Najkrótszy postój zasady headway (s modelu) - obudzeni z poczekalni zdążą wsiąść
+#define POLICY_MEAN_TRIP 6.0    // Średni czas podróży Ti ∈ [3,9] (s modelu)
+
+/*
+ * Funkcja policy_parse - odczyt opcji "nazwa[:parametr]"
+ * Parametry:
+ *   s - tekst opcji
+ *   policy, arg - wynik (arg = 0 gdy parametru nie podano - wartość domyślna)
+ *
+ * Zwraca 0 albo -1 dla nieznanej nazwy / ujemnego parametru.
+ */
+static inline int policy_parse(const char* s, int* policy, double* arg) {
+    const char* colon = strchr(s, ':');
+    size_t len = colon ? (size_t)(colon - s) : strlen(s);
+    *arg = colon ? atof(colon + 1) : 0;
+    if (*arg < 0) return -1;
+    for (int i = 0; i < POLICY_COUNT; i++) {
+        if (strlen(policy_names[i]) == len && strncmp(s, policy_names[i], len) == 0) {
+            *policy = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Funkcja policy_min_load - próg L zasady minload
+ */
+static inline int policy_min_load(int P, double arg) {
+    int L = arg > 0 ? (int)arg : P / 2;
+    if (L < 1) L = 1;
+    return L < P ? L : P;
+}
+
+/*
+ * Funkcja policy_headway - docelowy odstęp H między odjazdami (s modelu)
+ */
+static inline double policy_headway(int N, double T, double arg) {
+    return arg > 0 ? arg : (T + POLICY_MEAN_TRIP) / N;
+}
+
+/*
+ * Funkcja policy_ring_load - dodatkowy próg pasażerów, przy którym pasażer
+ * dzwoni na stanowisku (0 = brak; P i R dzwonią zawsze)
+ */
+static inline int policy_ring_load(int policy, int P, double arg) {
+    return policy == POLICY_MIN_LOAD ? policy_min_load(P, arg) : 0;
+}
+
+/*
+ * Funkcja policy_decide - decyzja o odjeździe
+ * Parametry:
+ *   policy, arg - zasada i jej parametr
+ *   N, P, R, T - parametry systemu
+ *   passengers, bikes - stan autobusu (ze słowa wsiadania)
+ *   waited - sekundy modelu od przyjazdu na stanowisko
+ *   since_depart - sekundy modelu od ostatniego odjazdu z dworca (< 0 = jeszcze nie było)
+ *   wait_more - [wyjście] najdłuższe dalsze czekanie (s modelu) przed ponowną decyzją
+ *
+ * Zwraca 1 = odjazd teraz, 0 = czekaj (najwyżej *wait_more, krócej gdy zadzwoni dzwonek).
+ */
+static inline int policy_decide(int policy, double arg, int N, int P, int R, double T,
+                                int passengers, int bikes, double waited, double since_depart,
+                                double* wait_more) {
+    int full = passengers >= P || (R > 0 && bikes >= R);
+    double cap = 2.0 * T;  // Najdłuższy postój zasad minload i headway
+
+    switch (policy) {
+    case POLICY_FIXED:
+        *wait_more = T - waited;
+        return waited >= T;
+
+    case POLICY_MIN_LOAD:
+        if (full || waited >= cap) return 1;
+        if (waited < T) {
+            *wait_more = T - waited;
+            return 0;
+        }
+        if (passengers >= policy_min_load(P, arg)) return 1;
+        *wait_more = cap - waited;  // Wcześniej obudzi dzwonek przy L osobach
+        return 0;
+
+    case POLICY_HEADWAY:
+        if (since_depart >= 0) {
+            if (full || waited >= cap) return 1;
+            double hold = policy_headway(N, T, arg) - since_depart;  // Do równego odstępu
+            double min = POLICY_MIN_DWELL - waited;
+            if (hold < min) hold = min;
+            if (hold > cap - waited) hold = cap - waited;
+            if (hold <= 0) return 1;
+            *wait_more = hold;
+            return 0;
+        }
+        // Pierwszy odjazd z dworca - brak odstępu do wyrównania, jak zasada full
+        // fall through
+    case POLICY_FULL:
+    default:
+        if (full || waited >= T) return 1;
+        *wait_more = T - waited;
+        return 0;
+    }
+}
+
+// === ZMIENNY POSTÓJ (DYSPOZYTOR) ===
+#define DWELL_TICK 1.0          // Okres pomiaru dyspozytora (s modelu)
+#define DWELL_ALPHA 0.1         // Waga nowej próbki EWMA (stała czasowa ~10 pomiarów)
+#define DWELL_STEP_MS 100       // Dokładność postoju (ms modelu)
+#define DWELL_HYSTERESIS_MS 500 // Mniejsze zmiany są pomijane (poza dojściem do granicy) - bez szumu w raporcie
+
+/*
+ * Struktura DwellEstimator - wygładzone (EWMA) wskaźniki popytu
+ */
+struct DwellEstimator {
+    double rate;                // Przybycia pasażerów na sekundę modelu
+    double queue;               // Pasażerowie w poczekalni
+    int primed;                 // 0 = brak pomiaru (pierwsza próbka bez wygładzania)
+};
+
+/*
+ * Funkcja dwell_observe - dodaje pomiar do estymatora
+ * Parametry:
+ *   est - estymator
+ *   arrivals - przybycia od poprzedniego pomiaru (licznik generatora)
+ *   dt - czas od poprzedniego pomiaru (s modelu)
+ *   waiting - bieżąca liczba pasażerów w poczekalni
+ */
+static inline void dwell_observe(struct DwellEstimator* est, long arrivals, double dt, long waiting) {
+    if (dt <= 0) return;
+    double rate = arrivals / dt;
+    if (!est->primed) {
+        est->rate = rate;
+        est->queue = waiting;
+        est->primed = 1;
+        return;
+    }
+    est->rate += DWELL_ALPHA * (rate - est->rate);
+    est->queue += DWELL_ALPHA * (waiting - est->queue);
+}
+
+/*
+ * Funkcja dwell_target - postój wyznaczony z estymatora (ms modelu)
+ * Parametry:
+ *   est - estymator
+ *   P - pojemność autobusu
+ *   buses - autobusy stojące naraz na dworcu (min(N, K))
+ *   min_s, max_s - granice postoju (s modelu)
+ *   current - bieżący postój (ms modelu); zwracany, gdy zmiana byłaby
+ *             mniejsza niż DWELL_HYSTERESIS_MS
+ *
+ * Postój to czas zapełnienia autobusu przy bieżącym popycie: wolne miejsca
+ * autobusów na dworcu (P razy buses minus kolejka z poczekalni, która
+ * wsiada od razu) podzielone przez częstość przybyć. W szczycie wychodzi
+ * krótko (autobus i tak zapełnia się szybko - niech robi miejsce
+ * następnemu), przy małym ruchu długo (dłużej zbiera pasażerów).
+ * Wynik zaokrąglony do DWELL_STEP_MS.
+ */
+static inline int dwell_target(const struct DwellEstimator* est, int P, int buses,
+                               double min_s, double max_s, int current) {
+    double t = max_s;
+    if (est->rate > 0) {
+        double seats = (double)P * buses - est->queue;
+        t = seats > 0 ? seats / est->rate : 0;
+    }
+    if (t < min_s) t = min_s;
+    if (t > max_s) t = max_s;
+    int ms = (int)(t * 1000.0 / DWELL_STEP_MS + 0.5) * DWELL_STEP_MS;
+    if (ms <= 0) ms = DWELL_STEP_MS;
+    int bound = t <= min_s || t >= max_s;
+    int diff = ms > current ? ms - current : current - ms;
+    return diff >= DWELL_HYSTERESIS_MS || (bound && diff > 0) ? ms : current;
+}
+
+#endif
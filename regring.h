@@ -0,0 +1,482 @@
+/*
+ * REGRING.H - Rejestracja w kasie przez pamięć dzieloną
+ *
+ * Dwa segmenty obok BusState:
+ * - tablica slotów odpowiedzi (zawsze): pasażer czekający na bilet rezerwuje
+ *   slot, a jego numer i generację wysyła w rejestracji; kasa wpisuje wynik
+ *   do slotu i budzi dokładnie tego pasażera. Dostarczenie biletu kosztuje
+ *   O(1) bez względu na liczbę czekających - bez msgrcv() z typem
+ *   MSG_TICKET_REPLY + PID, dla którego jądro przegląda kolejkę liniowo,
+ *   i bez odpowiedzi zajmujących bajty kolejki rejestracji,
+ * - pierścienie rejestracji (opcja --reg-ring): zamiast kolejki komunikatów
+ *   SysV (kopiowanie każdej struct msg do jądra i z powrotem, limit
+ *   msg_qbytes, przy którym msgsnd() po cichu blokuje) każde okienko kasy
+ *   ma własny pierścień (wielu producentów - pasażerowie, jeden konsument -
+ *   okienko); pasażer wybiera okienko po kolei (round robin).
+ *
+ * Na szybkiej ścieżce nie ma wywołań systemowych: futex (FUTEX_WAIT/WAKE na
+ * słowie w segmencie) jest używany tylko gdy druga strona naprawdę śpi -
+ * kasa bez rejestracji albo pasażer, który czeka na bilet dłużej.
+ *
+ * Plik .c, który dołącza ten nagłówek, musi zdefiniować _DEFAULT_SOURCE
+ * (syscall() dla futeksu - ring_futex_wait/wake z logring.h).
+ */
+
+#ifndef REGRING_H
+#define REGRING_H
+
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "ipc.h"
+#include "evlog.h"
+#include "logring.h"
+
+#define REG_RING_PROJ 'R'       // Znak dla ftok(SHM_PATH, ...) - segment pierścieni (--reg-ring)
+#define REPLY_PROJ 'Y'          // Znak dla ftok(SHM_PATH, ...) - segment slotów odpowiedzi
+#define REG_RING_SLOTS 2048     // Pozycje pierścienia jednego okienka (potęga dwójki)
+#define REPLY_SLOTS 4096        // Sloty odpowiedzi (najwięcej pasażerów czekających naraz na bilet)
+#define REPLY_CLAIM_WAIT_SEC 1.0  // Najdłuższy sen pasażera bez wolnego slotu odpowiedzi (sekundy modelu)
+#define REG_FULL_WAIT_SEC 1.0   // Najdłuższy sen pasażera na pełnym pierścieniu (sekundy modelu) - potem sprawdza shutdown
+
+// === STAN SLOTU ODPOWIEDZI ===
+// Słowo slotu: generacja << 3 | stan. Generacja rośnie przy każdej rezerwacji,
+// więc spóźniona odpowiedź (pasażer już zrezygnował) nie trafi do następnego
+// właściciela slotu.
+#define REPLY_FREE 0            // Slot wolny
+#define REPLY_WAITING 1         // Pasażer czeka na bilet (nie śpi)
+#define REPLY_SLEEPING 2        // Pasażer śpi na futeksie - kasa musi go obudzić
+#define REPLY_FILLING 3         // Kasa wpisuje wynik
+#define REPLY_READY 4           // Wynik gotowy
+#define REPLY_STATE(w) ((w) & 7u)
+#define REPLY_GEN(w) ((w) >> 3)
+#define REPLY_WORD(gen, state) (((gen) << 3) | (state))
+
+/*
+ * Slot pierścienia - jedna rejestracja
+ * seq: jak w logring.h (pozycja = wolny, RING_SEQ_CLAIMED | pid = pasażer
+ * kopiuje rejestrację, pozycja + 1 = zapisany, pozycja + REG_RING_SLOTS =
+ * odebrany albo pominięty przez kasę)
+ */
+struct RegSlot {
+    unsigned long seq;
+    struct msg m;               // Rejestracja (pole 'type' nieużywane)
+};
+
+/*
+ * Struktura RegQueue - pierścień jednego okienka
+ * 'tail' (pasażerowie) i 'head' (okienko) w osobnych liniach cache
+ */
+struct RegQueue {
+    unsigned long tail;         // Następna pozycja do zarezerwowania przez pasażera
+    unsigned long full_waits;   // Ile razy pasażer czekał na miejsce w pełnym pierścieniu
+    unsigned int space;         // Futex pasażerów czekających na miejsce (okienko zwiększa po odbiorze)
+    unsigned int space_waiters; // Liczba pasażerów śpiących na 'space'
+    char pad1[40];
+    unsigned long head;         // Następna pozycja do odczytu przez okienko
+    int sleeping;               // 1 = okienko śpi na futeksie (pasażer musi je obudzić)
+    unsigned long long stall_since;  // Od kiedy slot na pozycji head jest zarezerwowany, ale niegotowy (0 = brak)
+    unsigned long abandoned;    // Pominięte sloty pasażerów, którzy zginęli w trakcie zapisu (raportuje main)
+    char pad2[32];
+    struct RegSlot slots[REG_RING_SLOTS];
+};
+
+/*
+ * Struktura ReplySlot - odpowiedź kasy dla jednego pasażera
+ */
+struct ReplySlot {
+    unsigned int word;          // Generacja i stan (REPLY_*); futex pasażera
+    int ticket_ok;              // 1 = bilet wydany, 0 = odmowa (shutdown)
+    unsigned long long reg_ns;  // Rejestracja w kasie (histogram rejestracja→bilet)
+};
+
+/*
+ * Struktura RegRing - segment pierścieni rejestracji
+ */
+struct RegRing {
+    unsigned int next_window;   // Licznik round robin wyboru okienka
+    char pad[60];
+    struct RegQueue q[MAX_CASHIERS];
+};
+
+/*
+ * Struktura ReplyTable - segment slotów odpowiedzi kasy
+ * Futex 'free_seq' w osobnej linii cache niż sloty
+ */
+struct ReplyTable {
+    unsigned int free_seq;      // Futex pasażerów czekających na wolny slot (zwiększa reply_release)
+    unsigned int claim_waiters; // Liczba pasażerów śpiących na 'free_seq'
+    char pad[56];
+    struct ReplySlot slot[REPLY_SLOTS];
+};
+
+// === SEGMENT ===
+
+/*
+ * Funkcja reg_ring_init - przygotowuje puste pierścienie (wywoływana tylko przez main)
+ */
+static inline void reg_ring_init(struct RegRing* r) {
+    memset(r, 0, sizeof(*r));
+    for (int w = 0; w < MAX_CASHIERS; w++) {
+        for (unsigned long i = 0; i < REG_RING_SLOTS; i++) {
+            r->q[w].slots[i].seq = i;
+        }
+    }
+}
+
+/*
+ * Funkcja reg_shm_attach - podłącza istniejący segment (ftok(SHM_PATH, proj))
+ * Zwraca wskaźnik albo NULL gdy segmentu nie ma.
+ */
+static inline void* reg_shm_attach(int proj, size_t size) {
+    key_t key = ftok(SHM_PATH, proj);
+    if (key == -1) return NULL;
+    int id = shmget(key, size, 0600);
+    if (id == -1) return NULL;
+    void* p = shmat(id, NULL, 0);
+    return p == (void*)-1 ? NULL : p;
+}
+
+/*
+ * Funkcja reg_ring_attach - podłącza segment pierścieni rejestracji
+ *
+ * Zwraca wskaźnik albo NULL jeśli segment nie istnieje (bez --reg-ring).
+ */
+static inline struct RegRing* reg_ring_attach(void) {
+    return reg_shm_attach(REG_RING_PROJ, sizeof(struct RegRing));
+}
+
+/*
+ * Funkcja reply_table_attach - podłącza segment slotów odpowiedzi
+ */
+static inline struct ReplyTable* reply_table_attach(void) {
+    return reg_shm_attach(REPLY_PROJ, sizeof(struct ReplyTable));
+}
+
+// === SLOTY ODPOWIEDZI: PASAŻER ===
+
+/*
+ * Funkcja reply_claim - rezerwuje wolny slot odpowiedzi
+ * Parametry:
+ *   id - identyfikator pasażera (punkt startu przeszukiwania)
+ *   gen - [wyjście] generacja rezerwacji (wysyłana w rejestracji)
+ *
+ * Zwraca numer slotu albo -1 gdy wszystkie są zajęte.
+ */
+static inline int reply_claim(struct ReplyTable* t, int id, unsigned int* gen) {
+    unsigned int start = ((unsigned int)id * 2654435761u) % REPLY_SLOTS;  // Rozproszenie po tablicy
+    for (unsigned int k = 0; k < REPLY_SLOTS; k++) {
+        unsigned int i = (start + k) % REPLY_SLOTS;
+        unsigned int w = __atomic_load_n(&t->slot[i].word, __ATOMIC_RELAXED);
+        if (REPLY_STATE(w) != REPLY_FREE) continue;
+        unsigned int g = REPLY_GEN(w) + 1;
+        if (__atomic_compare_exchange_n(&t->slot[i].word, &w, REPLY_WORD(g, REPLY_WAITING), 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            *gen = g;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Funkcja reply_claim_wait - rezerwuje slot odpowiedzi, w razie potrzeby czekając
+ * Parametry:
+ *   bus - time_scale i słowo sterujące
+ *   id, gen - jak w reply_claim
+ *
+ * Wszystkie sloty zajęte = REPLY_SLOTS pasażerów czeka na bilet. Pasażer
+ * śpi wtedy na futeksie 'free_seq', który budzi reply_release (kasa wydała
+ * bilet, ktoś zrezygnował), najwyżej REPLY_CLAIM_WAIT_SEC - potem sprawdza
+ * shutdown. Zwraca numer slotu albo -1 gdy system się wyłącza.
+ */
+static inline int reply_claim_wait(struct ReplyTable* t, const struct BusState* bus, int id, unsigned int* gen) {
+    for (;;) {
+        int slot = reply_claim(t, id, gen);
+        if (slot >= 0) return slot;
+        if (bus_shutting_down(bus)) return -1;
+        unsigned int seen = __atomic_load_n(&t->free_seq, __ATOMIC_ACQUIRE);
+        __atomic_fetch_add(&t->claim_waiters, 1, __ATOMIC_RELAXED);
+        // Bariera: zapowiedź snu przed ponownym przeszukaniem slotów, tak samo
+        // po stronie reply_release (zwolnienie przed odczytem claim_waiters)
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        slot = reply_claim(t, id, gen);
+        if (slot < 0) {
+            ring_futex_wait(&t->free_seq, seen, REPLY_CLAIM_WAIT_SEC, bus->time_scale);
+        }
+        __atomic_fetch_sub(&t->claim_waiters, 1, __ATOMIC_RELAXED);
+        if (slot >= 0) return slot;
+    }
+}
+
+/*
+ * Funkcja reply_release - zwalnia slot (po odczycie biletu albo rezygnacji)
+ * Kasa w trakcie wpisywania (REPLY_FILLING) kończy za chwilę - czekamy.
+ * Budzi jednego pasażera czekającego w reply_claim_wait (jeśli jest).
+ */
+static inline void reply_release(struct ReplyTable* t, int slot, unsigned int gen) {
+    struct ReplySlot* s = &t->slot[slot];
+    for (;;) {
+        unsigned int w = __atomic_load_n(&s->word, __ATOMIC_ACQUIRE);
+        if (REPLY_GEN(w) != gen || REPLY_STATE(w) == REPLY_FREE) return;
+        if (REPLY_STATE(w) == REPLY_FILLING) {
+            sched_yield();
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&s->word, &w, REPLY_WORD(gen, REPLY_FREE), 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&t->claim_waiters, __ATOMIC_RELAXED)) {
+                __atomic_fetch_add(&t->free_seq, 1, __ATOMIC_RELEASE);
+                ring_futex_wake(&t->free_seq, 1);
+            }
+            return;
+        }
+    }
+}
+
+/*
+ * Funkcja reply_wait - czeka na bilet w slocie
+ * Parametry:
+ *   slot, gen - rezerwacja (reply_claim)
+ *   sec, scale - najdłuższe czekanie (sekundy modelu, bus->time_scale)
+ *
+ * Zwraca 1 gdy wynik jest gotowy (ticket_ok i reg_ns w slocie), 0 po upływie
+ * limitu - wywołujący sprawdza shutdown i czeka ponownie.
+ */
+static inline int reply_wait(struct ReplyTable* t, int slot, unsigned int gen, double sec, double scale) {
+    struct ReplySlot* s = &t->slot[slot];
+    int slept = 0;
+    for (;;) {
+        unsigned int w = __atomic_load_n(&s->word, __ATOMIC_ACQUIRE);
+        switch (REPLY_STATE(w)) {
+        case REPLY_READY:
+            return 1;
+        case REPLY_FILLING:
+            sched_yield();  // Kasa właśnie wpisuje wynik
+            continue;
+        case REPLY_WAITING:
+            // Zapowiadamy sen - kasa, która zobaczy REPLY_SLEEPING, obudzi nas futeksem
+            if (!__atomic_compare_exchange_n(&s->word, &w, REPLY_WORD(gen, REPLY_SLEEPING), 0,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+            // fall through
+        case REPLY_SLEEPING:
+            if (slept) {
+                // Limit minął - wracamy do stanu bez snu (kasa nie musi budzić)
+                w = REPLY_WORD(gen, REPLY_SLEEPING);
+                __atomic_compare_exchange_n(&s->word, &w, REPLY_WORD(gen, REPLY_WAITING), 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+                return REPLY_STATE(w) == REPLY_READY;
+            }
+            ring_futex_wait(&s->word, REPLY_WORD(gen, REPLY_SLEEPING), sec, scale);
+            slept = 1;
+            continue;
+        default:
+            return 0;  // Slot zwolniony - nie powinno się zdarzyć
+        }
+    }
+}
+
+// === SLOTY ODPOWIEDZI: KASA ===
+
+/*
+ * Funkcja reply_complete - kasa wpisuje wynik do slotu pasażera i budzi go
+ * Parametry:
+ *   slot, gen - rezerwacja z rejestracji
+ *   ok - 1 = bilet, 0 = odmowa
+ *   reg_ns - chwila rejestracji
+ *
+ * Zwraca 0 albo -1 gdy pasażer już zrezygnował (inna generacja / slot wolny).
+ */
+static inline int reply_complete(struct ReplyTable* t, int slot, unsigned int gen, int ok, unsigned long long reg_ns) {
+    if (slot < 0 || slot >= REPLY_SLOTS) return -1;
+    struct ReplySlot* s = &t->slot[slot];
+    unsigned int w = __atomic_load_n(&s->word, __ATOMIC_ACQUIRE);
+    for (;;) {
+        unsigned int st = REPLY_STATE(w);
+        if (REPLY_GEN(w) != gen || (st != REPLY_WAITING && st != REPLY_SLEEPING)) return -1;
+        if (__atomic_compare_exchange_n(&s->word, &w, REPLY_WORD(gen, REPLY_FILLING), 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+    s->ticket_ok = ok;
+    s->reg_ns = reg_ns;
+    __atomic_store_n(&s->word, REPLY_WORD(gen, REPLY_READY), __ATOMIC_RELEASE);
+    if (REPLY_STATE(w) == REPLY_SLEEPING) {
+        ring_futex_wake(&s->word, 1);  // Tylko ten pasażer
+    }
+    return 0;
+}
+
+// === PIERŚCIEŃ: PASAŻER (PRODUCENT) ===
+
+/*
+ * Funkcja reg_ring_push - wysyła rejestrację do okienka
+ * Parametry:
+ *   bus - liczba okienek (cashiers), time_scale i słowo sterujące
+ *   m - rejestracja (m->reply, m->reply_gen wypełnione albo -1 dla VIP)
+ *
+ * Przy pełnym pierścieniu (okienko nie nadąża) pasażer śpi na futeksie
+ * 'space', który okienko budzi po odebraniu rejestracji - takie czekanie
+ * jest liczone w full_waits, a nie ukryte w jądrze.
+ * Pozycję rezerwuje CAS na 'tail', a slot zajmuje CAS na 'seq'
+ * (RING_SEQ_CLAIMED | pid) przed skopiowaniem rejestracji. Jeśli okienko
+ * zdążyło pominąć rezerwację (RING_STALL_SEC), CAS zajęcia się nie udaje
+ * i pasażer bierze następną pozycję - nic nie zapisał do cudzego slotu.
+ * Zwraca 0 albo -1 gdy system się wyłącza (pierścień był pełny).
+ */
+static inline int reg_ring_push(struct RegRing* r, const struct BusState* bus, const struct msg* m) {
+    unsigned int w = __atomic_fetch_add(&r->next_window, 1, __ATOMIC_RELAXED) % (unsigned int)bus->cashiers;
+    struct RegQueue* q = &r->q[w];
+    unsigned long pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    struct RegSlot* slot;
+    for (;;) {
+        slot = &q->slots[pos & (REG_RING_SLOTS - 1)];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - pos);
+        if (seq & RING_SEQ_CLAIMED) {
+            // Slot zapisuje inny pasażer: z tego okrążenia (tail już dalej)
+            // albo z poprzedniego (pierścień pełny)
+            unsigned long t = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+            diff = t == pos ? -1 : 1;
+        }
+        if (diff == 0) {
+            if (!__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 0,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                continue;  // 'pos' zawiera aktualny tail
+            }
+            unsigned long expected = pos;
+            if (__atomic_compare_exchange_n(&slot->seq, &expected, ring_claim_word(), 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // Okienko pominęło rezerwację (czekała zbyt długo) - następna pozycja
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+        else if (diff < 0) {
+            // Pierścień pełny - śpimy aż okienko zwolni miejsce (albo shutdown)
+            if (bus_shutting_down(bus)) return -1;
+            __atomic_fetch_add(&q->full_waits, 1, __ATOMIC_RELAXED);
+            unsigned int seen = __atomic_load_n(&q->space, __ATOMIC_ACQUIRE);
+            __atomic_fetch_add(&q->space_waiters, 1, __ATOMIC_RELAXED);
+            // Bariera: zapowiedź snu przed ponownym odczytem slotu, tak samo po
+            // stronie okienka (odbiór przed odczytem space_waiters)
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == seq) {
+                ring_futex_wait(&q->space, seen, REG_FULL_WAIT_SEC, bus->time_scale);
+            }
+            __atomic_fetch_sub(&q->space_waiters, 1, __ATOMIC_RELAXED);
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+        else {
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+    }
+    // Slot jest nasz - okienko go nie pominie, dopóki żyjemy
+    slot->m = *m;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // Okienko śpi? Budzimy je (bariera: nasz zapis przed odczytem flagi,
+    // tak samo po stronie okienka - jedno z nas na pewno zobaczy drugie)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->sleeping, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&q->sleeping, 0, __ATOMIC_ACQ_REL)) {
+        ring_futex_wake((unsigned int*)&q->sleeping, 1);
+    }
+    return 0;
+}
+
+// === PIERŚCIEŃ: OKIENKO KASY (KONSUMENT) ===
+
+/*
+ * Funkcja reg_ring_pop - odbiera do max rejestracji z pierścienia okienka
+ * Zwraca liczbę odebranych (0 = pierścień pusty).
+ *
+ * Niegotowy slot na pozycji head (jak logger.c drain()) po RING_STALL_SEC
+ * sekundach modelu (scale = bus->time_scale):
+ * - zarezerwowany, ale niezajęty - pomijany; pasażer, jeśli żyje, weźmie
+ *   następną pozycję, więc rejestracja nie ginie,
+ * - zajęty - pomijany i liczony w 'abandoned' tylko gdy pasażer nie żyje;
+ *   bez tego okienko nie odebrałoby już żadnej rejestracji.
+ */
+static inline int reg_ring_pop(struct RegQueue* q, struct msg* out, int max, double scale) {
+    unsigned long head = q->head;  // Tylko to okienko zmienia head
+    int n = 0;
+    while (n < max) {
+        struct RegSlot* slot = &q->slots[head & (REG_RING_SLOTS - 1)];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != head + 1) {
+            if (seq == head && __atomic_load_n(&q->tail, __ATOMIC_RELAXED) <= head) break;
+            unsigned long long now = ev_now_ns();
+            if (q->stall_since == 0) {
+                q->stall_since = now;
+                break;
+            }
+            if (now - q->stall_since <= (unsigned long long)ring_stall_ns(scale)) break;
+            if ((seq & RING_SEQ_CLAIMED) && !ring_owner_dead(seq)) {
+                q->stall_since = now;  // Pasażer żyje - dokończy zapis
+                break;
+            }
+            unsigned long expected = seq;
+            if (__atomic_compare_exchange_n(&slot->seq, &expected, head + REG_RING_SLOTS, 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                if (seq & RING_SEQ_CLAIMED) __atomic_fetch_add(&q->abandoned, 1, __ATOMIC_RELAXED);
+                q->stall_since = 0;
+                head++;
+            }
+            continue;  // Pominięty albo pasażer zdążył zająć / opublikować slot - odczytaj ponownie
+        }
+        q->stall_since = 0;
+        out[n++] = slot->m;
+        __atomic_store_n(&slot->seq, head + REG_RING_SLOTS, __ATOMIC_RELEASE);
+        head++;
+    }
+    if (head != q->head) {
+        __atomic_store_n(&q->head, head, __ATOMIC_RELEASE);
+        // Zwolnione miejsce - budzimy pasażerów czekających na pełnym pierścieniu
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&q->space_waiters, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&q->space, 1, __ATOMIC_RELEASE);
+            ring_futex_wake(&q->space, INT_MAX);
+        }
+    }
+    return n;
+}
+
+/*
+ * Funkcja reg_ring_sleep - okienko bez rejestracji śpi do pobudki
+ * (rejestracja, shutdown - reg_ring_kick) albo najwyżej sec sekund
+ */
+static inline void reg_ring_sleep(struct RegQueue* q, double sec, double scale) {
+    __atomic_store_n(&q->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    struct RegSlot* slot = &q->slots[q->head & (REG_RING_SLOTS - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == q->head + 1) {
+        __atomic_store_n(&q->sleeping, 0, __ATOMIC_RELAXED);  // Zdążyła przyjść rejestracja
+        return;
+    }
+    ring_futex_wait((unsigned int*)&q->sleeping, 1, sec, scale);
+    __atomic_store_n(&q->sleeping, 0, __ATOMIC_RELAXED);
+}
+
+/*
+ * Funkcja reg_ring_kick - budzi wszystkie okienka i pasażerów czekających
+ * na miejsce w pełnym pierścieniu (shutdown)
+ */
+static inline void reg_ring_kick(struct RegRing* r, int windows) {
+    for (int w = 0; w < windows; w++) {
+        __atomic_store_n(&r->q[w].sleeping, 0, __ATOMIC_RELEASE);
+        ring_futex_wake((unsigned int*)&r->q[w].sleeping, INT_MAX);
+        __atomic_fetch_add(&r->q[w].space, 1, __ATOMIC_RELEASE);
+        ring_futex_wake(&r->q[w].space, INT_MAX);
+    }
+}
+
+#endif
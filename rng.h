@@ -0,0 +1,68 @@
+/*
+ * RNG.H - Powtarzalne strumienie liczb losowych (opcja --seed S)
+ *
+ * Każdy aktor systemu (generator, każdy kierowca, każdy pasażer) losuje
+ * z własnego, niezależnego strumienia. Strumień wyznacza ziarno z BusState
+ * i numer aktora (nie PID), więc ten sam --seed daje te same losowania
+ * niezależnie od kolejności uruchamiania procesów.
+ *
+ * Generator licznikowy: n-ta liczba strumienia to mieszanie (SplitMix64)
+ * klucza strumienia i numeru n. Bez stanu współdzielonego, bez blokad -
+ * kilka mnożeń i przesunięć na liczbę.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// === RODZAJE AKTORÓW (przestrzenie numerów strumieni) ===
+#define RNG_GENERATOR 1         // Generator pasażerów (numer 0)
+#define RNG_DRIVER 2            // Kierowca (numer = indeks kierowcy 0..N-1)
+#define RNG_PASSENGER 3         // Pasażer (numer = kolejny numer przybycia)
+
+/*
+ * Struktura Rng - strumień liczb losowych jednego aktora
+ */
+struct Rng {
+    uint64_t key;               // Klucz strumienia (ziarno + aktor)
+    uint64_t ctr;               // Numer ostatnio wylosowanej liczby
+};
+
+/*
+ * Funkcja rng_mix - funkcja mieszająca SplitMix64
+ */
+static inline uint64_t rng_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Funkcja rng_init - otwiera strumień aktora
+ * Parametry:
+ *   seed - ziarno przebiegu (bus->seed)
+ *   kind - RNG_GENERATOR / RNG_DRIVER / RNG_PASSENGER
+ *   index - numer aktora danego rodzaju
+ */
+static inline void rng_init(struct Rng* r, uint32_t seed, uint32_t kind, uint32_t index) {
+    r->key = rng_mix(((uint64_t)seed << 32) ^ rng_mix(((uint64_t)kind << 32) | index));
+    r->ctr = 0;
+}
+
+/*
+ * Funkcja rng_next - kolejna 64-bitowa liczba strumienia
+ */
+static inline uint64_t rng_next(struct Rng* r) {
+    return rng_mix(r->key + ++r->ctr * 0x9E3779B97F4A7C15ULL);
+}
+
+/*
+ * Funkcja rng_below - liczba z zakresu [0, n)
+ * (odpowiednik rand() % n)
+ */
+static inline int rng_below(struct Rng* r, int n) {
+    return (int)(rng_next(r) % (uint64_t)n);
+}
+
+#endif
@@ -0,0 +1,730 @@
+/*
+ * SIM.C - Symulacja z wirtualnym zegarem (tryb ./main ... --virtual-time H)
+ *
+ * Ten program odtwarza cały system w jednym procesie jako symulację
+ * zdarzeń dyskretnych. Zamiast sleep() każde opóźnienie (odstęp między
+ * pasażerami 1-3 s, postój T s, podróż 3-9 s) jest zdarzeniem w kolejce
+ * priorytetowej uporządkowanej po wirtualnym czasie. Zegar przeskakuje od
+ * zdarzenia do zdarzenia, więc H godzin pracy dworca liczy się w sekundach.
+ *
+ * Zasady są takie same jak w trybie procesowym:
+ * - pasażer: te same losowania cech, odmowa dzieci < 8 lat, rejestracja
+ *   w kasie, bilet dla nie-VIP dorosłych
+ * - wsiadanie: słowo wsiadania stanowiska, board_pick() i board_enter()
+ *   z board.h - ten sam kod co passenger.c; brak miejsca = poczekalnia
+ * - kierowca: K stanowisk, przyjazd budzi z poczekalni tylu pasażerów,
+ *   ilu się zmieści (najpierw z rowerem) - jak wake_waiting() w driver.c;
+ *   o końcu postoju decyduje ta sama zasada odjazdu (--policy, policy.h)
+ * - dyspozytor: przy --adaptive-dwell co sekundę dobiera postój T z popytu
+ *   (ten sam estymator EWMA co dispatcher.c)
+ * - po H godzinach: shutdown jak po SIGINT
+ *
+ * Raport (report.txt albo report.bin) zawiera te same zdarzenia co w trybie
+ * procesowym. Czas w raporcie to czas wirtualny liczony od startu programu.
+ * Kierowcy, okienka kasy, dyspozytor i generator dostają wirtualne PID
+ * (1, 2, 3...), pasażerowie kolejne numery - tak jak w trybie puli.
+ *
+ * Losowania pochodzą z tych samych strumieni co w trybie procesowym (rng.h):
+ * generator, kierowca i (numer przybycia) pasażer. Z --seed S zegar raportu
+ * startuje od 00:00:00, więc dwa przebiegi z tym samym S dają identyczny
+ * raport (bajt w bajt).
+ *
+ * Pomijamy to, czego nie da się odtworzyć bez procesów: sygnały dyspozytora
+ * (wymuszony odjazd, blokada dworca) i czas obsługi w kasie (bilet od ręki).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "ipc.h"
+#include "evlog.h"
+#include "rng.h"
+#include "policy.h"
+#include "board.h"
+
+#define SIM_SEC 1000000000ULL   // Sekunda czasu wirtualnego (ns)
+
+// === ZDARZENIA SYMULACJI ===
+enum SimKind {
+    SIM_GENERATE,               // Generator: przybycie kolejnego pasażera
+    SIM_DEPART,                 // Kierowca: decyzja zasady odjazdu - odjazd albo dalszy postój (id = kierowca)
+    SIM_RETURN,                 // Kierowca: powrót z trasy (id = kierowca)
+    SIM_DISPATCH,               // Dyspozytor: pomiar popytu i nowy postój (--adaptive-dwell)
+    SIM_SHUTDOWN                // Koniec symulowanego czasu pracy
+};
+
+/*
+ * Struktura SimEvent - wpis kolejki zdarzeń
+ * seq rozstrzyga remisy czasu w kolejności planowania (FIFO)
+ */
+struct SimEvent {
+    unsigned long long t;       // Czas wirtualny (ns)
+    unsigned long seq;          // Numer kolejny planowania
+    int kind;                   // enum SimKind
+    int id;                     // Numer kierowcy (SIM_DEPART, SIM_RETURN)
+};
+
+/*
+ * Struktura SimPassenger - pasażer w poczekalni
+ */
+struct SimPassenger {
+    int id;                     // Numer pasażera w raporcie
+    int vip;
+    int bike;
+    int child;                  // 1 = z dzieckiem (2 miejsca)
+};
+
+/*
+ * Struktura SimQueue - kolejka FIFO pasażerów (poczekalnia)
+ */
+struct SimQueue {
+    struct SimPassenger* q;
+    size_t head, len, cap;
+};
+
+// Stan kierowcy
+enum { DRV_QUEUED, DRV_PLATFORM, DRV_TRIP, DRV_DONE };
+
+struct SimDriver {
+    int pid;                    // Wirtualny PID
+    int state;                  // DRV_*
+    int platform;               // Zajmowane stanowisko (DRV_PLATFORM)
+    int Ti;                     // Czas ostatniej podróży
+    unsigned long long arrive_at;  // Czas przyjazdu na stanowisko (postój dla zasady odjazdu)
+    unsigned long long depart_at;  // Termin kolejnej decyzji o odjeździe (inne SIM_DEPART są nieaktualne)
+    struct Rng rng;             // Strumień losowy kierowcy (czasy podróży)
+};
+
+// === KONFIGURACJA ===
+int N, P, R, T;                 // Parametry jak w main
+int platforms = 1;              // Liczba stanowisk (--platforms K)
+int cashiers = 1;               // Liczba okienek kasy (--cashiers C)
+int log_binary = 0;             // 1 = report.bin
+double arrival_rate = 1.0;      // Mnożnik częstości przybyć (--arrival-rate X)
+unsigned int seed;              // Ziarno strumieni losowych (--seed S)
+int policy = POLICY_FULL;       // Zasada odjazdu (--policy)
+double policy_arg = 0;          // Parametr zasady (0 = domyślny)
+double dwell_min, dwell_max;    // Granice zmiennego postoju (--adaptive-dwell; 0 = stały T)
+
+// === STAN SYMULACJI ===
+unsigned long long now;         // Aktualny czas wirtualny (ns)
+struct SimEvent* heap;          // Kopiec zdarzeń (min po t, seq)
+size_t heap_len, heap_cap;
+unsigned long next_seq;
+struct Platform platform[MAX_PLATFORMS];
+struct SimDriver* drivers;
+int* station_queue;             // Kierowcy czekający na wolne stanowisko (FIFO)
+int sq_head, sq_len;
+struct SimQueue room, room_bike;  // Poczekalnie (bez roweru / z rowerem)
+struct SimPassenger* woken;     // Obudzeni przy przyjeździe (najwyżej P)
+int station_blocked;
+unsigned long long last_depart; // Czas ostatniego odjazdu z dworca (zasada headway)
+int any_departed;               // 1 = był już odjazd (wcześniej brak odstępu)
+int dwell_ms;                   // Bieżący postój T (ms) - jak BusState.dwell_ms
+struct DwellEstimator dwell_est;  // Estymator popytu dyspozytora
+long dwell_prev_arrivals;       // Licznik przybyć przy poprzednim pomiarze
+int next_pid = 1;               // Kolejny wirtualny PID
+int main_pid, dispatcher_pid, generator_pid;
+int cashier_pid[MAX_CASHIERS];
+long window_reg[MAX_CASHIERS];  // Rejestracje na okienko
+long registrations;             // Wszystkie rejestracje (wybór okienka)
+struct Rng gen_rng;             // Strumień losowy generatora (odstępy)
+
+// === STATYSTYKI ===
+long passengers, departures, boarded;
+
+// === RAPORT ===
+FILE* rep;
+int64_t clock_offset;           // Czas ścienny startu symulacji
+
+/*
+ * Funkcja log_event - zapisuje zdarzenie do raportu z czasem wirtualnym
+ * Parametry:
+ *   e - rekord zdarzenia (pid = 0 oznacza proces główny)
+ *
+ * Jeden proces - piszemy buforowanym strumieniem, bez pierścienia logów
+ */
+void log_event(struct EvRecord e) {
+    e.ts_ns = now;
+    if (e.pid == 0) e.pid = main_pid;
+    if (log_binary) {
+        fwrite(&e, sizeof(e), 1, rep);
+        return;
+    }
+    char clk[16];
+    char ln[256];
+    ev_clock(e.ts_ns, clock_offset, clk, sizeof(clk));
+    int len = ev_format(&e, clk, ln, sizeof(ln));
+    if (len > 0) fwrite(ln, 1, (size_t)len, rep);
+}
+
+// === KOLEJKA ZDARZEŃ (KOPIEC BINARNY) ===
+
+/*
+ * Funkcja ev_before - czy zdarzenie a jest przed b
+ */
+int ev_before(const struct SimEvent* a, const struct SimEvent* b) {
+    return a->t < b->t || (a->t == b->t && a->seq < b->seq);
+}
+
+/*
+ * Funkcja schedule - planuje zdarzenie za 'delay' ns czasu wirtualnego
+ */
+void schedule(unsigned long long delay, int kind, int id) {
+    if (heap_len == heap_cap) {
+        heap_cap = heap_cap ? heap_cap * 2 : 64;
+        heap = realloc(heap, heap_cap * sizeof(*heap));
+        if (!heap) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    size_t i = heap_len++;
+    heap[i] = (struct SimEvent){ now + delay, next_seq++, kind, id };
+    while (i > 0) {
+        size_t up = (i - 1) / 2;
+        if (!ev_before(&heap[i], &heap[up])) break;
+        struct SimEvent tmp = heap[i];
+        heap[i] = heap[up];
+        heap[up] = tmp;
+        i = up;
+    }
+}
+
+/*
+ * Funkcja next_event - zdejmuje najwcześniejsze zdarzenie
+ * Zwraca 0 gdy kolejka jest pusta
+ */
+int next_event(struct SimEvent* out) {
+    if (heap_len == 0) return 0;
+    *out = heap[0];
+    heap[0] = heap[--heap_len];
+    size_t i = 0;
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < heap_len && ev_before(&heap[l], &heap[m])) m = l;
+        if (r < heap_len && ev_before(&heap[r], &heap[m])) m = r;
+        if (m == i) break;
+        struct SimEvent tmp = heap[i];
+        heap[i] = heap[m];
+        heap[m] = tmp;
+        i = m;
+    }
+    return 1;
+}
+
+// === POCZEKALNIA ===
+
+void queue_push(struct SimQueue* q, struct SimPassenger p) {
+    if (q->len == q->cap) {
+        size_t cap = q->cap ? q->cap * 2 : 64;
+        struct SimPassenger* nq = malloc(cap * sizeof(*nq));
+        if (!nq) {
+            perror("malloc");
+            exit(1);
+        }
+        for (size_t i = 0; i < q->len; i++) {
+            nq[i] = q->q[(q->head + i) % q->cap];
+        }
+        free(q->q);
+        q->q = nq;
+        q->head = 0;
+        q->cap = cap;
+    }
+    q->q[(q->head + q->len) % q->cap] = p;
+    q->len++;
+}
+
+struct SimPassenger queue_pop(struct SimQueue* q) {
+    struct SimPassenger p = q->q[q->head];
+    q->head = (q->head + 1) % q->cap;
+    q->len--;
+    return p;
+}
+
+// === WSIADANIE (board.h - ten sam kod co passenger.c) ===
+
+/*
+ * Funkcja ring_if_full - autobus zapełniony (jak w passenger.c)
+ * Pasażer, który przekroczył próg P pasażerów, R rowerów albo L osób zasady
+ * minload, "dzwoni" - kierowca od razu pyta zasadę o odjazd, a zaplanowana
+ * wcześniej decyzja staje się nieaktualna
+ */
+void ring_if_full(int pl, unsigned long long before, unsigned long long after) {
+    int L = policy_ring_load(policy, P, policy_arg);
+    int seats_full = BOARD_PASSENGERS(before) < P && BOARD_PASSENGERS(after) >= P;
+    int bikes_full = R > 0 && BOARD_BIKES(before) < R && BOARD_BIKES(after) >= R;
+    int load_reached = L > 0 && BOARD_PASSENGERS(before) < L && BOARD_PASSENGERS(after) >= L;
+    if (!seats_full && !bikes_full && !load_reached) return;
+    for (int d = 0; d < N; d++) {
+        if (drivers[d].state == DRV_PLATFORM && drivers[d].platform == pl && drivers[d].depart_at != now) {
+            drivers[d].depart_at = now;
+            schedule(0, SIM_DEPART, d);
+        }
+    }
+}
+
+/*
+ * Funkcja try_board - próba wejścia do autobusu
+ * Sukces = zdarzenie wsiadania w raporcie, brak miejsca = poczekalnia
+ * (na koniec kolejki, tak jak ponowne zapisanie się w passenger.c)
+ */
+void try_board(struct SimPassenger p) {
+    int seats = p.child ? 2 : 1;
+    int bikes = p.bike ? 1 : 0;
+    unsigned long long before = 0;
+    int pl = board_pick(platform, platforms, P, R, seats, bikes, &before);
+    if (pl == -1) {
+        queue_push(p.bike ? &room_bike : &room, p);
+        return;
+    }
+    board_enter(&platform[pl].board, before, BOARD_MAKE(seats, bikes));  // Jeden proces - CAS zawsze się udaje
+    log_event((struct EvRecord){ .pid = p.id, .type = p.child ? EV_FAMILY_BOARD : EV_PASSENGER_BOARD,
+                                 .vip = p.vip, .bike = p.bike });
+    ring_if_full(pl, before, platform[pl].board);
+}
+
+/*
+ * Funkcja wake_waiting - budzi pasażerów z poczekalni (jak w driver.c)
+ * Parametry:
+ *   pl - stanowisko, na które właśnie przyjechał autobus
+ *
+ * Budzi tylu, ilu zmieści się w autobusie: najpierw z rowerem, potem
+ * resztę. Obudzeni od razu próbują wsiąść; rodzic z dzieckiem, który się
+ * nie zmieści, wraca do poczekalni.
+ */
+void wake_waiting(int pl) {
+    unsigned long long w = platform[pl].board;
+    int seats = P - BOARD_PASSENGERS(w);
+    int bikes = R - BOARD_BIKES(w);
+
+    int kb = (int)room_bike.len;
+    if (kb > bikes) kb = bikes;
+    if (kb > seats) kb = seats;
+    if (kb < 0) kb = 0;
+    seats -= kb;
+
+    int kn = (int)room.len;
+    if (kn > seats) kn = seats;
+    if (kn < 0) kn = 0;
+
+    // Najpierw zdejmujemy obudzonych, dopiero potem próbują wsiąść -
+    // ci, którzy wrócą do poczekalni, trafią za pozostałych czekających
+    int n = 0;
+    for (int i = 0; i < kb; i++) woken[n++] = queue_pop(&room_bike);
+    for (int i = 0; i < kn; i++) woken[n++] = queue_pop(&room);
+    for (int i = 0; i < n; i++) try_board(woken[i]);
+}
+
+/*
+ * Funkcja arrival_delay - odstęp do następnego pasażera (jak w generatorze)
+ * 1-3 s podzielone przez mnożnik częstości przybyć
+ */
+unsigned long long arrival_delay() {
+    int delay = 1 + rng_below(&gen_rng, 3);
+    return (unsigned long long)(delay * (double)SIM_SEC / arrival_rate);
+}
+
+// === PASAŻER (jak serve_passenger w passenger.c) ===
+
+/*
+ * Funkcja passenger_arrive - nowy pasażer na dworcu
+ */
+void passenger_arrive() {
+    struct SimPassenger p;
+    p.id = next_pid++;
+    passengers++;
+    struct Rng rng;  // Strumień pasażera: ziarno + numer przybycia (jak w generatorze)
+    rng_init(&rng, seed, RNG_PASSENGER, (uint32_t)passengers);
+    p.vip = (rng_below(&rng, 100) == 0);  // 1% szans na VIP
+    p.bike = rng_below(&rng, 2);  // 50% szans na rower
+    int age = rng_below(&rng, 80);  // Wiek 0-79
+    p.child = (age >= 18 && rng_below(&rng, 5) == 0);  // 20% dorosłych ma dziecko
+
+    log_event((struct EvRecord){ .pid = p.id, .type = EV_PASSENGER_ARRIVE, .vip = p.vip, .age = age,
+                                 .bike = p.bike, .child = p.child });
+
+    if (age < 8) {
+        log_event((struct EvRecord){ .pid = p.id, .type = EV_CHILD_REFUSED });
+        return;
+    }
+
+    // Rejestracja: okienka obsługują kolejne rejestracje po kolei
+    int w = (int)(registrations++ % cashiers);
+    window_reg[w]++;
+    log_event((struct EvRecord){ .pid = cashier_pid[w], .type = EV_CASHIER_REGISTER, .arg = p.id, .arg2 = w,
+                                 .passengers = cashiers, .vip = p.vip, .child = 0 });
+
+    if (!p.vip && log_binary) {
+        log_event((struct EvRecord){ .pid = p.id, .type = EV_PASSENGER_TICKET, .arg = 0 });  // Bilet od ręki (tylko report.bin)
+    }
+    try_board(p);
+}
+
+// === KIEROWCA (jak driver.c) ===
+
+/*
+ * Funkcja depart_delay - decyzja zasady odjazdu dla kierowcy na stanowisku
+ * Zwraca 0 = odjazd teraz, inaczej opóźnienie (ns) do kolejnej decyzji
+ */
+unsigned long long depart_delay(int d) {
+    unsigned long long w = platform[drivers[d].platform].board;
+    double waited = (double)(now - drivers[d].arrive_at) / SIM_SEC;
+    double since = any_departed ? (double)(now - last_depart) / SIM_SEC : -1.0;
+    double wait_more;
+    if (policy_decide(policy, policy_arg, N, P, R, dwell_ms / 1000.0, BOARD_PASSENGERS(w), BOARD_BIKES(w),
+                      waited, since, &wait_more)) {
+        return 0;
+    }
+    unsigned long long delay = (unsigned long long)(wait_more * SIM_SEC + 0.5);
+    return delay > 0 ? delay : 1;  // Zegar musi ruszyć - inaczej decyzja w kółko w tej samej chwili
+}
+
+/*
+ * Funkcja driver_arrive - autobus wjeżdża na dworzec
+ * Bez wolnego stanowiska kierowca czeka w kolejce (semafor dworca)
+ */
+void driver_arrive(int d) {
+    int pl = -1;
+    for (int i = 0; i < platforms; i++) {
+        if (platform[i].driver_pid == 0) {
+            pl = i;
+            break;
+        }
+    }
+    if (pl == -1) {
+        drivers[d].state = DRV_QUEUED;
+        station_queue[(sq_head + sq_len++) % N] = d;
+        return;
+    }
+    drivers[d].state = DRV_PLATFORM;
+    drivers[d].platform = pl;
+    platform[pl].driver_pid = drivers[d].pid;
+    platform[pl].board = BOARD_MAKE(0, 0);  // Pusty, drzwi otwarte
+    log_event((struct EvRecord){ .pid = drivers[d].pid, .type = EV_DRIVER_ARRIVE, .arg = pl });
+    drivers[d].arrive_at = now;
+    unsigned long long delay = depart_delay(d);
+    drivers[d].depart_at = now + delay;
+    schedule(delay, SIM_DEPART, d);
+    wake_waiting(pl);  // Może zapełnić autobus - wtedy decyzja od razu
+}
+
+/*
+ * Funkcja release_platform - autobus opuszcza stanowisko
+ * Na zwolnione stanowisko wjeżdża pierwszy czekający kierowca
+ */
+void release_platform(int d) {
+    int pl = drivers[d].platform;
+    platform[pl].board = BOARD_DEPARTING;
+    platform[pl].driver_pid = 0;
+    if (sq_len > 0 && !station_blocked) {
+        int next = station_queue[sq_head];
+        sq_head = (sq_head + 1) % N;
+        sq_len--;
+        driver_arrive(next);
+    }
+}
+
+/*
+ * Funkcja driver_depart - decyzja zasady odjazdu: dalszy postój albo
+ * zamknięcie drzwi i odjazd
+ */
+void driver_depart(int d) {
+    if (drivers[d].state != DRV_PLATFORM) return;  // Stanowisko zwolnione przy shutdown
+    if (now != drivers[d].depart_at) return;  // Decyzja zastąpiona dzwonkiem (albo z poprzedniego postoju)
+    unsigned long long delay = depart_delay(d);
+    if (delay > 0) {
+        drivers[d].depart_at = now + delay;  // Zasada każe czekać
+        schedule(delay, SIM_DEPART, d);
+        return;
+    }
+    int pl = drivers[d].platform;
+    unsigned long long w = platform[pl].board | BOARD_DEPARTING;
+    int p = BOARD_PASSENGERS(w);
+    int r = BOARD_BIKES(w);
+    boarded += p;
+    departures++;
+    last_depart = now;
+    any_departed = 1;
+    log_event((struct EvRecord){ .pid = drivers[d].pid, .type = EV_DRIVER_DEPART, .arg = pl,
+                                 .passengers = p, .bikes = r });
+
+    drivers[d].state = DRV_TRIP;
+    drivers[d].Ti = rng_below(&drivers[d].rng, 7) + 3;  // Podróż 3-9 s
+    release_platform(d);
+    schedule((unsigned long long)drivers[d].Ti * SIM_SEC, SIM_RETURN, d);
+}
+
+/*
+ * Funkcja driver_return - powrót z trasy
+ */
+void driver_return(int d) {
+    log_event((struct EvRecord){ .pid = drivers[d].pid, .type = EV_DRIVER_RETURN, .arg = drivers[d].Ti });
+    if (station_blocked) {
+        drivers[d].state = DRV_DONE;
+        log_event((struct EvRecord){ .pid = drivers[d].pid, .type = EV_DRIVER_END });
+        return;
+    }
+    driver_arrive(d);
+}
+
+// === DYSPOZYTOR (jak adapt_dwell w dispatcher.c) ===
+
+/*
+ * Funkcja dispatcher_tick - pomiar popytu i nowy postój T
+ */
+void dispatcher_tick() {
+    int buses = N < platforms ? N : platforms;
+    dwell_observe(&dwell_est, passengers - dwell_prev_arrivals, DWELL_TICK, (long)(room.len + room_bike.len));
+    dwell_prev_arrivals = passengers;
+    int ms = dwell_target(&dwell_est, P, buses, dwell_min, dwell_max, dwell_ms);
+    if (ms != dwell_ms) {
+        dwell_ms = ms;
+        log_event((struct EvRecord){ .pid = dispatcher_pid, .type = EV_DISPATCHER_DWELL, .arg = ms,
+                                     .arg2 = (int)(dwell_est.rate * 1000.0 + 0.5),
+                                     .passengers = (int16_t)(dwell_est.queue < 32767 ? dwell_est.queue + 0.5 : 32767) });
+    }
+}
+
+// === SHUTDOWN (jak handle_sigint w main.c) ===
+
+/*
+ * Funkcja shutdown - koniec symulowanego czasu pracy
+ * Generator, dyspozytor i kasa kończą się od razu, poczekalnia się
+ * opróżnia, kierowcy na dworcu zwalniają stanowiska. Autobusy w trasie
+ * kończą kurs (SIM_RETURN) i dopiero wtedy kierowcy kończą pracę.
+ */
+void shutdown_sim() {
+    station_blocked = 1;
+    log_event((struct EvRecord){ .type = EV_MAIN_SHUTDOWN });
+    log_event((struct EvRecord){ .pid = dispatcher_pid, .type = EV_DISPATCHER_END });
+    log_event((struct EvRecord){ .pid = generator_pid, .type = EV_GENERATOR_END });
+
+    // Poczekalnia: pasażerowie widzą shutdown (rodzina kończy bez wpisu, jak w passenger.c)
+    while (room_bike.len > 0 || room.len > 0) {
+        struct SimPassenger p = queue_pop(room_bike.len > 0 ? &room_bike : &room);
+        if (!p.child) {
+            log_event((struct EvRecord){ .pid = p.id, .type = EV_PASSENGER_CLOSED_WAIT });
+        }
+    }
+    for (int i = 0; i < cashiers; i++) {
+        log_event((struct EvRecord){ .pid = cashier_pid[i], .type = EV_CASHIER_END, .arg = i, .passengers = cashiers });
+    }
+
+    // Kierowcy na dworcu i w kolejce do stanowiska
+    for (int d = 0; d < N; d++) {
+        if (drivers[d].state == DRV_PLATFORM) {
+            release_platform(d);
+        }
+        if (drivers[d].state == DRV_PLATFORM || drivers[d].state == DRV_QUEUED) {
+            drivers[d].state = DRV_DONE;
+            log_event((struct EvRecord){ .pid = drivers[d].pid, .type = EV_DRIVER_END });
+        }
+    }
+    sq_len = 0;
+}
+
+int main(int argc, char** argv) {
+    // === PARSOWANIE ARGUMENTÓW (te same co w main) ===
+    if (argc < 5) {
+        fprintf(stderr, "Uzycie: %s N P R T --virtual-time H [opcje]\n", argv[0]);
+        return 1;
+    }
+    N = atoi(argv[1]);
+    P = atoi(argv[2]);
+    R = atoi(argv[3]);
+    T = atoi(argv[4]);
+    if (N <= 0 || P <= 0 || R < 0 || T <= 0) {
+        fprintf(stderr, "Niepoprawne parametry\n");
+        return 1;
+    }
+
+    double hours = 0;  // Symulowany czas pracy dworca
+    int seeded = 0;  // 1 = podano --seed (raport powtarzalny)
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--binary-log") == 0) {
+            log_binary = 1;
+        }
+        else if (strcmp(argv[i], "--virtual-time") == 0 && i + 1 < argc) {
+            hours = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--platforms") == 0 && i + 1 < argc) {
+            platforms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--arrival-rate") == 0 && i + 1 < argc) {
+            arrival_rate = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+            seeded = 1;
+        }
+        else if (strcmp(argv[i], "--cashiers") == 0 && i + 1 < argc) {
+            cashiers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--adaptive-dwell") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lf:%lf", &dwell_min, &dwell_max) != 2 ||
+                dwell_min <= 0 || dwell_max < dwell_min) {
+                fprintf(stderr, "Niepoprawne granice postoju (MIN:MAX, 0 < MIN <= MAX)\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            if (policy_parse(argv[++i], &policy, &policy_arg) == -1) {
+                fprintf(stderr, "Nieznana zasada odjazdu: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if ((strcmp(argv[i], "--passenger-pool") == 0 || strcmp(argv[i], "--time-scale") == 0 ||
+                  strcmp(argv[i], "--metrics") == 0) && i + 1 < argc) {
+            i++;  // Bez znaczenia - pasażerowie nie są procesami, czas jest wirtualny, brak eksportera
+        }
+        else if (strcmp(argv[i], "--reg-ring") == 0) {
+            // Bez znaczenia - kasa nie jest procesem, rejestracja nie ma drogi IPC
+        }
+        else {
+            fprintf(stderr, "Nieznana opcja: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (hours <= 0 || arrival_rate <= 0 || platforms < 1 || platforms > MAX_PLATFORMS ||
+        cashiers < 1 || cashiers > MAX_CASHIERS) {
+        fprintf(stderr, "Niepoprawne parametry symulacji\n");
+        return 1;
+    }
+
+    // === RAPORT ===
+    // Czas wirtualny liczony od 0; w raporcie dodajemy czas ścienny startu,
+    // a przy --seed stałą północ - wtedy raport nie zależy od chwili uruchomienia
+    if (seeded) {
+        struct tm midnight = { .tm_year = 70, .tm_mday = 1, .tm_isdst = -1 };
+        clock_offset = (int64_t)mktime(&midnight) * 1000000000LL;
+    }
+    else {
+        seed = (unsigned)(time(NULL) ^ getpid());
+        clock_offset = ev_clock_offset() + (int64_t)ev_now_ns();
+    }
+    rep = fopen(log_binary ? EV_REPORT_BIN : EV_REPORT_TXT, "w");
+    if (!rep) {
+        perror("fopen report");
+        return 1;
+    }
+    if (log_binary) {
+        struct EvFileHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, EV_MAGIC, sizeof(EV_MAGIC));
+        hdr.version = EV_VERSION;
+        hdr.record_size = sizeof(struct EvRecord);
+        hdr.clock_offset_ns = clock_offset;
+        fwrite(&hdr, sizeof(hdr), 1, rep);
+    }
+
+    // === INICJALIZACJA STANU ===
+    rng_init(&gen_rng, seed, RNG_GENERATOR, 0);
+    dwell_ms = T * 1000;  // Postój startowy (jak w main.c)
+    if (dwell_max > 0) {
+        if (dwell_ms < dwell_min * 1000) dwell_ms = (int)(dwell_min * 1000);
+        if (dwell_ms > dwell_max * 1000) dwell_ms = (int)(dwell_max * 1000);
+    }
+    for (int i = 0; i < MAX_PLATFORMS; i++) {
+        platform[i].board = BOARD_DEPARTING;  // Brak autobusu - drzwi zamknięte
+        platform[i].driver_pid = 0;
+    }
+    drivers = calloc((size_t)N, sizeof(*drivers));
+    station_queue = calloc((size_t)N, sizeof(*station_queue));
+    woken = calloc((size_t)P, sizeof(*woken));
+    if (!drivers || !station_queue || !woken) {
+        perror("calloc");
+        return 1;
+    }
+
+    struct timespec w0, w1;
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+
+    // === START "PROCESÓW" (kolejność jak w main.c) ===
+    main_pid = next_pid++;
+    log_event((struct EvRecord){ .type = EV_MAIN_START, .arg = N, .passengers = P, .bikes = R, .arg2 = T });
+    log_event((struct EvRecord){ .type = EV_MAIN_SEED, .arg = (int)seed });
+    for (int d = 0; d < N; d++) {
+        drivers[d].pid = next_pid++;
+        rng_init(&drivers[d].rng, seed, RNG_DRIVER, (uint32_t)d);
+        log_event((struct EvRecord){ .pid = drivers[d].pid, .type = EV_DRIVER_START });
+    }
+    for (int i = 0; i < cashiers; i++) {
+        cashier_pid[i] = next_pid++;
+        log_event((struct EvRecord){ .pid = cashier_pid[i], .type = EV_CASHIER_START, .arg = i, .passengers = cashiers });
+    }
+    dispatcher_pid = next_pid++;
+    log_event((struct EvRecord){ .pid = dispatcher_pid, .type = EV_DISPATCHER_START });
+    generator_pid = next_pid++;
+    log_event((struct EvRecord){ .pid = generator_pid, .type = EV_GENERATOR_START });
+
+    for (int d = 0; d < N; d++) {
+        driver_arrive(d);
+    }
+    schedule(arrival_delay(), SIM_GENERATE, 0);
+    schedule((unsigned long long)(hours * 3600.0 * SIM_SEC), SIM_SHUTDOWN, 0);
+    if (dwell_max > 0) {
+        schedule((unsigned long long)(DWELL_TICK * SIM_SEC), SIM_DISPATCH, 0);
+    }
+
+    // === PĘTLA ZDARZEŃ ===
+    struct SimEvent ev;
+    while (next_event(&ev)) {
+        now = ev.t;
+        switch (ev.kind) {
+        case SIM_GENERATE:
+            if (station_blocked) break;  // Generator zakończony
+            passenger_arrive();
+            schedule(arrival_delay(), SIM_GENERATE, 0);
+            break;
+        case SIM_DEPART:
+            driver_depart(ev.id);
+            break;
+        case SIM_RETURN:
+            driver_return(ev.id);
+            break;
+        case SIM_DISPATCH:
+            if (station_blocked) break;  // Dyspozytor zakończony
+            dispatcher_tick();
+            schedule((unsigned long long)(DWELL_TICK * SIM_SEC), SIM_DISPATCH, 0);
+            break;
+        case SIM_SHUTDOWN:
+            shutdown_sim();
+            break;
+        }
+    }
+
+    // === ZAKOŃCZENIE (jak w main.c) ===
+    for (int i = 0; i < cashiers; i++) {
+        int permille = registrations > 0 ? (int)(window_reg[i] * 1000 / registrations) : 0;
+        log_event((struct EvRecord){ .type = EV_MAIN_CASHIER_LOAD, .arg = i, .arg2 = (int)window_reg[i],
+                                     .passengers = (int16_t)permille });
+    }
+    // Zużycie zasobów: cała symulacja to jeden proces (poza --seed, bo zależy od maszyny)
+    struct rusage self;
+    if (!seeded && getrusage(RUSAGE_SELF, &self) == 0) {
+        long cpu_ms = (self.ru_utime.tv_sec + self.ru_stime.tv_sec) * 1000L +
+                      (self.ru_utime.tv_usec + self.ru_stime.tv_usec) / 1000;
+        log_event((struct EvRecord){ .type = EV_MAIN_RUSAGE, .passengers = EV_COMP_MAIN, .bikes = 1,
+                                     .arg = (int)cpu_ms, .arg2 = (int)(self.ru_nvcsw + self.ru_nivcsw) });
+    }
+    log_event((struct EvRecord){ .type = EV_MAIN_END });
+    fclose(rep);
+
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+    double wall = (double)(w1.tv_sec - w0.tv_sec) + (double)(w1.tv_nsec - w0.tv_nsec) / 1e9;
+    printf("Symulacja %.2f h w %.3f s: pasazerow %ld, odjazdow %ld, przewiezionych %ld\n",
+           (double)now / 3600.0 / SIM_SEC, wall, passengers, departures, boarded);
+
+    free(heap);
+    free(drivers);
+    free(station_queue);
+    free(woken);
+    free(room.q);
+    free(room_bike.q);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * STATS.H - Segment statystyk na żywo (narzędzie busstat)
+ *
+ * Osobny segment pamięci dzielonej z licznikami zdarzeń i bieżącymi
+ * wartościami (poczekalnia, wypełnienie autobusów). Procesy systemu tylko
+ * dodają do liczników atomowo (bez semafora 0), a busstat podłącza segment
+ * w trybie tylko do odczytu - monitorowanie nie spowalnia gorącej ścieżki.
+ *
+ * Każdy licznik leży w osobnej linii cache, żeby procesy zwiększające różne
+ * liczniki (kasa - rejestracje, pasażerowie - wejścia) nie unieważniały
+ * sobie nawzajem linii.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "ipc.h"
+
+#define STATS_PROJ 'T'          // Znak dla ftok(SHM_PATH, ...) - osobny segment obok BusState
+
+// === LICZNIKI ===
+enum StatId {
+    // Liczniki narastające (busstat pokazuje przyrost na sekundę)
+    ST_ARRIVALS = 0,            // Pasażerowie wygenerowani (generator)
+    ST_REGISTRATIONS,           // Rejestracje odebrane przez kasę (kasa)
+    ST_TICKETS,                 // Wydane bilety (kasa)
+    ST_BOARDINGS,               // Osoby, które weszły do autobusu, z dziećmi (pasażer)
+    ST_DEPARTURES,              // Odjazdy autobusów (kierowca)
+    ST_CHILD_REFUSED,           // Odrzucone dzieci bez opiekuna (pasażer)
+    ST_CLOSED_REFUSED,          // Odmowy przy zamkniętym dworcu / shutdown (pasażer)
+    // Wartości bieżące (busstat pokazuje stan)
+    ST_WAITING,                 // Pasażerowie w poczekalniach (pasażer: wejście/wyjście)
+    ST_ON_BOARD,                // Osoby w autobusach stojących na stanowiskach
+    ST_COUNT
+};
+
+#define ST_FIRST_GAUGE ST_WAITING
+
+/*
+ * Struktura StatCounter - jeden licznik w osobnej linii cache
+ */
+struct StatCounter {
+    long value;
+    char pad[56];
+} __attribute__((aligned(64)));
+
+/*
+ * Struktura BusStats - segment statystyk
+ */
+struct BusStats {
+    int P;                      // Pojemność autobusu (do wypełnienia w %)
+    int platforms;              // Liczba stanowisk
+    int done;                   // 1 = system zakończył pracę (busstat kończy)
+    char pad[52];
+    struct StatCounter c[ST_COUNT];
+};
+
+/*
+ * Funkcja stats_attach - podłącza segment statystyk do zapisu
+ *
+ * Zwraca wskaźnik albo NULL jeśli segment nie istnieje
+ * (wtedy stat_add nic nie robi).
+ */
+static inline struct BusStats* stats_attach(void) {
+    key_t key = ftok(SHM_PATH, STATS_PROJ);
+    if (key == -1) return NULL;
+    int id = shmget(key, sizeof(struct BusStats), 0600);
+    if (id == -1) return NULL;
+    void* p = shmat(id, NULL, 0);
+    if (p == (void*)-1) return NULL;
+    return (struct BusStats*)p;
+}
+
+/*
+ * Funkcja stat_add - dodaje n do licznika (atomowo, bez blokad)
+ */
+static inline void stat_add(struct BusStats* s, int id, long n) {
+    if (s) __atomic_fetch_add(&s->c[id].value, n, __ATOMIC_RELAXED);
+}
+
+/*
+ * Funkcja stat_read - odczyt licznika (busstat)
+ */
+static inline long stat_read(const struct BusStats* s, int id) {
+    return __atomic_load_n(&s->c[id].value, __ATOMIC_RELAXED);
+}
+
+#endif
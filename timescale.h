@@ -0,0 +1,87 @@
+/*
+ * TIMESCALE.H - Przyspieszanie czasu w trybie procesowym (opcja --time-scale X)
+ *
+ * Wszystkie opóźnienia systemu (odstęp między pasażerami, postój, podróż,
+ * limity czekania pasażera) podawane są w sekundach "modelu" i dzielone
+ * przez bus->time_scale. Przy X = 50 sekunda modelu trwa 20 ms.
+ *
+ * Czekanie odbywa się do bezwzględnego terminu na zegarze monotonicznym
+ * (clock_nanosleep z TIMER_ABSTIME): kolejny termin liczymy od poprzedniego,
+ * a nie od chwili obudzenia, więc opóźnienia obsługi i sygnały nie
+ * przesuwają harmonogramu (brak narastającego dryfu).
+ */
+
+#ifndef TIMESCALE_H
+#define TIMESCALE_H
+
+#include <time.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#define TIME_SCALE_MAX 1000.0   // Największe dopuszczalne przyspieszenie
+
+/*
+ * Funkcja ts_now - bieżący czas monotoniczny (początek harmonogramu)
+ */
+static inline void ts_now(struct timespec* t) {
+    clock_gettime(CLOCK_MONOTONIC, t);
+}
+
+/*
+ * Funkcja ts_add - przesuwa termin o 'sec' sekund modelu
+ * Parametry:
+ *   t - termin (modyfikowany)
+ *   sec - opóźnienie w sekundach modelu
+ *   scale - przyspieszenie (bus->time_scale)
+ */
+static inline void ts_add(struct timespec* t, double sec, double scale) {
+    long long ns = (long long)(sec / scale * 1e9);
+    ns += t->tv_nsec;
+    t->tv_sec += (time_t)(ns / 1000000000LL);
+    t->tv_nsec = (long)(ns % 1000000000LL);
+}
+
+/*
+ * Funkcja ts_before - czy termin a jest wcześniej niż b
+ */
+static inline int ts_before(const struct timespec* a, const struct timespec* b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+/*
+ * Funkcja ts_sleep_until - śpi do bezwzględnego terminu
+ *
+ * Zwraca 0 po osiągnięciu terminu albo EINTR gdy przerwał sygnał
+ * (clock_nanosleep nie jest wznawiany mimo SA_RESTART) - wywołujący
+ * sprawdza swoje flagi i woła ponownie z tym samym terminem.
+ */
+static inline int ts_sleep_until(const struct timespec* t) {
+    return clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL);
+}
+
+/*
+ * Funkcja ts_sleep - śpi 'sec' sekund modelu, niezależnie od sygnałów
+ */
+static inline void ts_sleep(double sec, double scale) {
+    struct timespec t;
+    ts_now(&t);
+    ts_add(&t, sec, scale);
+    while (ts_sleep_until(&t) == EINTR);
+}
+
+/*
+ * Funkcja ts_alarm - odpowiednik alarm() dla sekund modelu
+ * SIGALRM po 'sec' sekundach modelu; sec = 0 wyłącza alarm
+ */
+static inline void ts_alarm(double sec, double scale) {
+    struct itimerval it = { { 0, 0 }, { 0, 0 } };
+    if (sec > 0) {
+        long long us = (long long)(sec / scale * 1e6);
+        if (us < 1) us = 1;  // 0 oznaczałoby wyłączenie timera
+        it.it_value.tv_sec = (time_t)(us / 1000000);
+        it.it_value.tv_usec = (suseconds_t)(us % 1000000);
+    }
+    setitimer(ITIMER_REAL, &it, NULL);
+}
+
+#endif